@@ -0,0 +1,56 @@
+#include "archetypes.h"
+
+void RecruitPlatoon::clear() {
+    posX.clear(); posY.clear();
+    velX.clear(); velY.clear();
+    stamina.clear();
+    held.clear(); heldBy.clear(); latchTimer.clear();
+    sandPits.clear();
+    frame.clear();
+    count = 0;
+    heldTotal = 0;
+}
+
+int RecruitPlatoon::add(Vector2 pos, float initialStamina) {
+    posX.push_back(pos.x); posY.push_back(pos.y);
+    velX.push_back(0.0f); velY.push_back(0.0f);
+    stamina.push_back(initialStamina);
+    held.push_back(0); heldBy.push_back(-1); latchTimer.push_back(0);
+    sandPits.push_back(0);
+    frame.push_back(0);
+    return count++;
+}
+
+void RecruitPlatoon::hold(int i, int di) {
+    if (!held[i]) heldTotal++;
+    held[i] = 1;
+    heldBy[i] = di;
+    latchTimer[i] = 0;
+}
+
+void RecruitPlatoon::release(int i) {
+    if (held[i]) heldTotal--;
+    held[i] = 0;
+    heldBy[i] = -1;
+    latchTimer[i] = 0;
+}
+
+void PickupSet::clear() {
+    posX.clear(); posY.clear();
+    collected.clear();
+    count = 0;
+    remaining = 0;
+}
+
+int PickupSet::add(Vector2 pos) {
+    posX.push_back(pos.x); posY.push_back(pos.y);
+    collected.push_back(0);
+    remaining++;
+    return count++;
+}
+
+void PickupSet::collect(int i) {
+    if (collected[i]) return;
+    collected[i] = 1;
+    remaining--;
+}
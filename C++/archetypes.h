@@ -0,0 +1,82 @@
+#ifndef ARCHETYPES_H
+#define ARCHETYPES_H
+
+#include "common.h"
+#include <vector>
+
+// The components the movement system works on, as one archetype lays them out: parallel arrays
+// indexed by entity. Any archetype that has them hands out a MoverArrays and gets moved the same way.
+struct MoverArrays {
+    float* x;
+    float* y;
+    const float* vx;   // Step for this tick
+    const float* vy;
+    const int* held;   // Nonzero entities stay put
+    int count;
+};
+
+// Recruits in structure-of-arrays form. The platoon takes one SimInput per tick and every recruit
+// carries it out on its own: own stamina, own collisions, own DI holding on to it. Recruit 0 is
+// the one the camera follows and the HUD describes.
+class RecruitPlatoon {
+private:
+    std::vector<float> posX, posY;  // Top-left corner of each recruit sprite
+    std::vector<float> velX, velY;  // Step for this tick, written by the stamina system
+    std::vector<float> stamina;
+    std::vector<int> held;          // 1 while a DI holds the recruit (int to match MoverArrays)
+    std::vector<int> heldBy;        // Index of that DI, -1 when free
+    std::vector<int> latchTimer;    // Ticks held so far
+    std::vector<int> sandPits;      // Sand pits entered by the last move, for the stamina system
+    std::vector<int> frame;         // Walking animation frame
+    int count = 0;
+    int heldTotal = 0;
+
+public:
+    void clear();
+    int add(Vector2 pos, float initialStamina);
+    int size() const { return count; }
+
+    Vector2 position(int i) const { return Vector2(posX[i], posY[i]); }
+    void setPosition(int i, Vector2 pos) { posX[i] = pos.x; posY[i] = pos.y; }
+    void setVelocity(int i, Vector2 step) { velX[i] = step.x; velY[i] = step.y; }
+    float getStamina(int i) const { return stamina[i]; }
+    void setStamina(int i, float value) { stamina[i] = value; }
+    bool isHeld(int i) const { return held[i] != 0; }
+    int holder(int i) const { return heldBy[i]; }
+    void hold(int i, int di);
+    void release(int i);
+    int heldCount() const { return heldTotal; }
+    int heldTicks(int i) const { return latchTimer[i]; }
+    int tickLatch(int i) { return ++latchTimer[i]; }
+    int sandPitsEntered(int i) const { return sandPits[i]; }
+    int* sandPitCounts() { return sandPits.data(); }
+    int animationFrame(int i) const { return frame[i]; }
+    void advanceFrame(int i, int frames) { frame[i] = (frame[i] + 1) % frames; }
+    const float* xs() const { return posX.data(); }
+    const float* ys() const { return posY.data(); }
+    const int* frames() const { return frame.data(); }
+    MoverArrays movers() { return {posX.data(), posY.data(), velX.data(), velY.data(), held.data(), count}; }
+};
+
+// Objectives lying on the map. Collected ones stay in place (flagged), so indices never shift.
+class PickupSet {
+private:
+    std::vector<float> posX, posY;
+    std::vector<int> collected;
+    int count = 0;
+    int remaining = 0;
+
+public:
+    void clear();
+    int add(Vector2 pos);
+    int size() const { return count; }
+    int remainingCount() const { return remaining; }
+
+    Vector2 position(int i) const { return Vector2(posX[i], posY[i]); }
+    bool isCollected(int i) const { return collected[i] != 0; }
+    void collect(int i);
+    const float* xs() const { return posX.data(); }
+    const float* ys() const { return posY.data(); }
+};
+
+#endif // ARCHETYPES_H
@@ -0,0 +1,89 @@
+#include "asset_loader.h"
+#include <algorithm>
+#include <chrono>
+
+AssetLoader::AssetLoader(int threadCount) {
+    if (threadCount <= 0) threadCount = std::min(LOADER_MAX_THREADS, std::max(1, SDL_GetCPUCount() - 1));
+    for (int i = 0; i < threadCount; ++i) workers.emplace_back(&AssetLoader::workerLoop, this);
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void AssetLoader::add(LoadJob job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back({std::move(job), nullptr});
+        total++;
+    }
+    taskReady.notify_one();
+}
+
+// Pop and run the oldest task; called with the lock held, which is released while the job runs
+bool AssetLoader::runTask(std::unique_lock<std::mutex>& lock) {
+    if (tasks.empty()) return false;
+    Task task = std::move(tasks.front());
+    tasks.pop_front();
+    bool skip = failed || stopping;  // Fail fast: nothing new starts after the first error
+    lock.unlock();
+    bool ok = !skip && task.job();
+    lock.lock();
+    completed++;
+    if (!ok) failed = true;
+    if (task.batch) {
+        task.batch->pending--;
+        task.batch->ok = task.batch->ok && ok;
+    }
+    taskDone.notify_all();
+    return true;
+}
+
+void AssetLoader::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (stopping && tasks.empty()) return;
+        runTask(lock);
+    }
+}
+
+// For jobs that fan out (the atlas decoding its images): the caller runs queued tasks itself while it
+// waits, so a batch started from a worker cannot deadlock the pool.
+bool AssetLoader::runBatch(const std::vector<LoadJob>& jobs) {
+    Batch batch = {static_cast<int>(jobs.size()), true};
+    std::unique_lock<std::mutex> lock(mutex);
+    for (const auto& job : jobs) tasks.push_back({job, &batch});
+    total += static_cast<int>(jobs.size());
+    taskReady.notify_all();
+    while (batch.pending > 0) {
+        if (!runTask(lock)) taskDone.wait(lock);
+    }
+    return batch.ok;
+}
+
+bool AssetLoader::waitFor(int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (completed < total) taskDone.wait_for(lock, std::chrono::milliseconds(timeoutMs));
+    return completed == total;
+}
+
+bool AssetLoader::isDone() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return completed == total;
+}
+
+bool AssetLoader::succeeded() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !failed;
+}
+
+float AssetLoader::progress() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return total > 0 ? static_cast<float>(completed) / total : 1.0f;
+}
@@ -0,0 +1,56 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include "common.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const int LOADER_MAX_THREADS = 8;  // Decoding is bound by disk and zlib; more workers stop helping
+
+// One load step for a worker. Returns false, after saying why on std::cerr, when a required asset is
+// missing or broken. Jobs only produce CPU-side data (surfaces, chunks, files): textures are created
+// afterwards on the render thread.
+typedef std::function<bool()> LoadJob;
+
+// Runs the startup asset decoding on a small worker pool, so loading takes as long as the slowest files
+// rather than all of them in a row, while the main thread keeps the window alive with a progress screen.
+// The first failed job stops the rest from starting (fail-fast); succeeded() then reports it.
+class AssetLoader {
+private:
+    struct Batch {
+        int pending;
+        bool ok;
+    };
+    struct Task {
+        LoadJob job;
+        Batch* batch;  // Set for jobs queued by runBatch()
+    };
+    std::vector<std::thread> workers;
+    std::deque<Task> tasks;
+    std::mutex mutex;
+    std::condition_variable taskReady, taskDone;
+    int total = 0, completed = 0;
+    bool failed = false, stopping = false;
+
+    void workerLoop();
+    bool runTask(std::unique_lock<std::mutex>& lock);
+
+public:
+    explicit AssetLoader(int threadCount = 0);  // 0 picks one worker per spare core
+    ~AssetLoader();                             // Drops jobs that have not started and joins the workers
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    void add(LoadJob job);
+    bool runBatch(const std::vector<LoadJob>& jobs);  // Queue jobs and help run them until all are finished
+    bool waitFor(int timeoutMs);                      // Wait for a job to finish; true once everything has
+    bool isDone();
+    bool succeeded();
+    float progress();                                 // Finished share of the jobs queued so far
+};
+
+#endif // ASSET_LOADER_H
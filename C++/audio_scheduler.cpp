@@ -0,0 +1,64 @@
+#include "audio_scheduler.h"
+#include <iostream>
+
+static const SoundRule SOUND_RULES[SOUND_COUNT] = {
+    {600, 1, 2, true},    // SOUND_DI_YELL: one at a time, never crowded out by footsteps
+    {250, 2, 1, false},   // SOUND_FOOTSTEP: a step every quarter second at most, overlapping by one
+};
+
+void AudioScheduler::init() {
+    if (Mix_AllocateChannels(AUDIO_CHANNELS) != AUDIO_CHANNELS) {
+        std::cerr << "Failed to allocate mixer channels: " << Mix_GetError() << std::endl;
+        return;
+    }
+    Mix_ReserveChannels(AUDIO_RESERVED_CHANNELS);  // Mix_PlayChannel(-1, ...) elsewhere can't take them
+    open = true;
+}
+
+// Channel for sound in its pool: a finished one, else the oldest lower-priority voice, else -1
+int AudioScheduler::pickChannel(SoundId sound, Uint32 now) {
+    const SoundRule& rule = SOUND_RULES[sound];
+    int first = rule.reserved ? 0 : AUDIO_RESERVED_CHANNELS;
+    int last = rule.reserved ? AUDIO_RESERVED_CHANNELS : AUDIO_CHANNELS;
+    int playing = 0;
+    int freeChannel = -1, victim = -1;
+    for (int channel = first; channel < last; ++channel) {
+        Voice& voice = voices[channel];
+        if (voice.sound >= 0 && !Mix_Playing(channel)) voice.sound = -1;
+        if (voice.sound < 0) {
+            if (freeChannel < 0) freeChannel = channel;
+            continue;
+        }
+        if (voice.sound == sound) playing++;
+        if (SOUND_RULES[voice.sound].priority < rule.priority &&
+            (victim < 0 || now - voice.startedAt > now - voices[victim].startedAt)) {
+            victim = channel;
+        }
+    }
+    if (playing >= rule.maxVoices) return -1;
+    return freeChannel >= 0 ? freeChannel : victim;
+}
+
+bool AudioScheduler::play(SoundId sound, Uint32 now) {
+    if (!open || !chunks[sound]) return false;
+    if (started[sound] && now - lastStart[sound] < SOUND_RULES[sound].cooldownMs) return false;  // Checked first, it rejects most requests
+    int channel = pickChannel(sound, now);
+    if (channel < 0 || Mix_PlayChannel(channel, chunks[sound], 0) < 0) {  // Playing on a busy channel halts its voice
+        dropped++;
+        return false;
+    }
+    voices[channel].sound = sound;
+    voices[channel].startedAt = now;
+    lastStart[sound] = now;
+    started[sound] = true;
+    return true;
+}
+
+void AudioScheduler::playMusic(Mix_Music* music) {
+    if (music && Mix_PlayMusic(music, -1) < 0) std::cerr << "Failed to play music: " << Mix_GetError() << std::endl;
+}
+
+void AudioScheduler::stopAll() {
+    if (open) Mix_HaltChannel(-1);
+    for (Voice& voice : voices) voice.sound = -1;
+}
@@ -0,0 +1,50 @@
+#ifndef AUDIO_SCHEDULER_H
+#define AUDIO_SCHEDULER_H
+
+#include "common.h"
+
+const int AUDIO_CHANNELS = 8;           // Mixer voices in total; mixing cost is capped by this, not by entity count
+const int AUDIO_RESERVED_CHANNELS = 2;  // Channels 0..1, kept for sounds that must never be starved by the rest
+
+enum SoundId {
+    SOUND_DI_YELL,
+    SOUND_FOOTSTEP,
+    SOUND_COUNT
+};
+
+// How often and how widely one sound may play
+struct SoundRule {
+    Uint32 cooldownMs;  // Requests sooner than this after the last start are dropped
+    int maxVoices;      // Voices of this sound playing at once
+    int priority;       // A request may steal a channel from a lower-priority voice
+    bool reserved;      // Plays on the reserved channels instead of the shared ones
+};
+
+// Game audio events in front of SDL_mixer. Each request passes the sound's cooldown and voice cap,
+// then takes a free channel in its pool, or steals the oldest voice of lower priority, or is dropped.
+// The chunks and music are owned by the caller; music streams through Mix_PlayMusic as before.
+class AudioScheduler {
+private:
+    struct Voice {
+        int sound = -1;  // SoundId playing on this channel, -1 when never used
+        Uint32 startedAt = 0;
+    };
+    Mix_Chunk* chunks[SOUND_COUNT] = {};
+    Uint32 lastStart[SOUND_COUNT] = {};
+    bool started[SOUND_COUNT] = {};
+    Voice voices[AUDIO_CHANNELS];
+    bool open = false;
+    int dropped = 0;
+
+    int pickChannel(SoundId sound, Uint32 now);
+
+public:
+    void init();  // After Mix_OpenAudio
+    void setSound(SoundId sound, Mix_Chunk* chunk) { chunks[sound] = chunk; }
+    bool play(SoundId sound, Uint32 now);
+    void playMusic(Mix_Music* music);
+    void stopAll();  // Before the chunks are freed
+    int droppedCount() const { return dropped; }
+};
+
+#endif // AUDIO_SCHEDULER_H
@@ -0,0 +1,332 @@
+// benchmark.cpp
+// Benchmark suite for the hot paths: scene rendering on SDL's software renderer (no window, no GPU),
+// the simulation step with collision, the dust particle update and HUD text. Every scenario runs on a
+// generated map with a fixed seed, so numbers are comparable between builds on the same machine.
+//
+//   make benchmark
+//   ./benchmark [--quick] [--filter NAME] [--json results.json]
+#include "common.h"
+#include "map_format.h"
+#include "world_map.h"
+#include "rendering.h"
+#include "text_renderer.h"
+#include "texture_atlas.h"
+#include "particle_system.h"
+#include "sim_core.h"
+#include "rng.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// Every heap allocation in the process goes through here, so each benchmark can report allocations per op
+static std::atomic<Uint64> allocationCount(0);
+static std::atomic<Uint64> allocationBytes(0);
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+struct Scenario {
+    const char* name;
+    int mapSize;     // Width and height of the generated map
+    int structures;  // Rects spread over all categories
+    int entities;    // Drill instructors
+    int particles;   // Live dust particles
+};
+
+static const Scenario SCENARIOS[] = {
+    {"small", 2000, 50, 1, 256},
+    {"medium", 4000, 500, 64, 4096},
+    {"large", 8000, 4000, 512, 32768},
+};
+
+struct BenchResult {
+    std::string name;
+    const Scenario* scenario;
+    long long iterations;  // Ops timed; for sim_step, the ticks actually simulated
+    long long restarts;    // Times finished() asked for a fresh start
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+struct BenchOptions {
+    double minSeconds = 0.5;  // --quick: 0.1
+    std::string filter;
+    std::string jsonPath;
+};
+
+// Write a compiled map with structures rects of random size and category (no textures)
+static bool writeSyntheticMap(const std::string& path, const Scenario& scenario) {
+    Rng rng(scenario.structures);
+    std::vector<MapFileRect> rects[MAP_FILE_CATEGORY_COUNT];
+    for (int i = 0; i < scenario.structures; ++i) {
+        MapFileRect rect;
+        rect.w = 32 + rng.below(224);
+        rect.h = 32 + rng.below(224);
+        rect.x = rng.below(scenario.mapSize - rect.w);
+        rect.y = rng.below(scenario.mapSize - rect.h);
+        rects[rng.below(MAP_FILE_CATEGORY_COUNT)].push_back(rect);
+    }
+
+    MapFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAP_FILE_MAGIC, sizeof(MAP_FILE_MAGIC));
+    header.version = MAP_FILE_VERSION;
+    header.width = scenario.mapSize;
+    header.height = scenario.mapSize;
+    uint32_t offset = sizeof(MapFileHeader);
+    for (uint32_t i = 0; i < MAP_FILE_CATEGORY_COUNT; ++i) {
+        header.categories[i].rectOffset = offset;
+        header.categories[i].rectCount = static_cast<uint32_t>(rects[i].size());
+        header.categories[i].textureName = MAP_FILE_NO_STRING;
+        offset += header.categories[i].rectCount * sizeof(MapFileRect);
+    }
+    header.stringTableOffset = offset;
+
+    FILE* out = std::fopen(path.c_str(), "wb");
+    if (!out) return false;
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1;
+    for (uint32_t i = 0; i < MAP_FILE_CATEGORY_COUNT && ok; ++i) {
+        if (!rects[i].empty()) ok = std::fwrite(rects[i].data(), sizeof(MapFileRect), rects[i].size(), out) == rects[i].size();
+    }
+    return (std::fclose(out) == 0) && ok;
+}
+
+// Load the synthetic map for scenario; the file is removed right away, the mapping keeps it alive
+static bool loadSyntheticMap(WorldMap& world, const Scenario& scenario) {
+    std::string path = std::string("benchmark_") + scenario.name + ".pim";
+    bool ok = writeSyntheticMap(path, scenario) && world.load(path);
+    std::remove(path.c_str());
+    return ok;
+}
+
+// Run op until minSeconds have passed (at least 10 times) after a short warm-up. When finished()
+// says op would no longer do any work, restart() runs outside the timing and allocation counts.
+static BenchResult measure(const std::string& name, const Scenario& scenario, const BenchOptions& options, const std::function<void()>& op,
+                           const std::function<bool()>& finished = nullptr, const std::function<void()>& restart = nullptr) {
+    for (int i = 0; i < 3; ++i) {
+        if (finished && finished()) restart();
+        op();
+    }
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 budget = static_cast<Uint64>(options.minSeconds * frequency);
+    Uint64 allocsBefore = allocationCount.load(), bytesBefore = allocationBytes.load();
+    Uint64 start = SDL_GetPerformanceCounter(), elapsed = 0;
+    long long iterations = 0, restarts = 0;
+    while (iterations < 10 || elapsed < budget) {
+        if (finished && finished()) {
+            Uint64 pauseStart = SDL_GetPerformanceCounter();
+            Uint64 allocsPaused = allocationCount.load(), bytesPaused = allocationBytes.load();
+            restart();
+            restarts++;
+            allocsBefore += allocationCount.load() - allocsPaused;
+            bytesBefore += allocationBytes.load() - bytesPaused;
+            start += SDL_GetPerformanceCounter() - pauseStart;
+        }
+        op();
+        iterations++;
+        elapsed = SDL_GetPerformanceCounter() - start;
+    }
+    BenchResult result;
+    result.name = name;
+    result.scenario = &scenario;
+    result.iterations = iterations;
+    result.restarts = restarts;
+    result.nsPerOp = static_cast<double>(elapsed) * 1e9 / frequency / iterations;
+    result.allocsPerOp = static_cast<double>(allocationCount.load() - allocsBefore) / iterations;
+    result.bytesPerOp = static_cast<double>(allocationBytes.load() - bytesBefore) / iterations;
+    return result;
+}
+
+// Solid-color stand-ins for the sprite files, packed like the game packs the real ones
+static void addPlaceholderSprites(TextureAtlas& atlas) {
+    auto add = [&atlas](const std::string& name, SDL_Color color) {
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, SPRITE_SIZE, SPRITE_SIZE, 32, SDL_PIXELFORMAT_RGBA32);
+        if (!surface) return;
+        SDL_FillRect(surface, NULL, SDL_MapRGBA(surface->format, color.r, color.g, color.b, color.a));
+        atlas.addSurface(name, surface);
+    };
+    for (int i = 0; i < RECRUIT_FRAMES; ++i) add("recruit_walk" + std::to_string(i + 1), GREEN);
+    for (int i = 0; i < DI_FRAMES; ++i) add("di_yell" + std::to_string(i + 1), TAN);
+    add("gear", BROWN);
+    for (int i = 0; i < CATEGORY_COUNT; ++i) add(MAP_CATEGORY_NAMES[i], GRAY);
+}
+
+// DIs and particles spread over the view, the way a busy frame looks
+static void benchRenderScene(const Scenario& scenario, const WorldMap& world, const BenchOptions& options, std::vector<BenchResult>& results) {
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, WIDTH, HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    if (!renderer) {
+        std::cerr << "render_scene skipped: " << SDL_GetError() << std::endl;
+        if (target) SDL_FreeSurface(target);
+        return;
+    }
+    {
+        TextureAtlas atlas;
+        addPlaceholderSprites(atlas);
+        Renderer sceneRenderer(nullptr, renderer);
+        if (atlas.build("") && atlas.upload(renderer)) sceneRenderer.setSprites(atlas);
+        sceneRenderer.initializeMap(&world);
+
+        Rng rng(scenario.entities);
+        Vector2 camera(static_cast<float>((world.width() - WIDTH) / 2), static_cast<float>((world.height() - HEIGHT) / 2));
+        std::vector<float> diX(scenario.entities), diY(scenario.entities);
+        for (int i = 0; i < scenario.entities; ++i) {
+            diX[i] = camera.x + rng.below(WIDTH);
+            diY[i] = camera.y + rng.below(HEIGHT);
+        }
+        for (int i = 0; i < scenario.particles; ++i) {
+            sceneRenderer.getDustParticles().spawn(Vector2(camera.x + rng.below(WIDTH), camera.y + rng.below(HEIGHT)));
+        }
+        sceneRenderer.setCamera(camera);
+        float recruitX = camera.x + WIDTH / 2, recruitY = camera.y + HEIGHT / 2;
+        float gearX = recruitX + 64, gearY = recruitY;
+        int frame = 0;
+        results.push_back(measure("render_scene", scenario, options, [&]() {
+            int recruitFrame = frame % RECRUIT_FRAMES;
+            sceneRenderer.renderScene(&recruitX, &recruitY, &recruitFrame, 1, diX.data(), diY.data(), scenario.entities, &gearX, &gearY, 1,
+                                      75.0f, 0.3f, frame % DI_FRAMES);
+            frame++;
+        }));
+    }
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(target);
+}
+
+// One simulation tick with collision for the recruit and every DI, under wandering input. A game that
+// is over is started again untimed: step() does nothing once it is lost and leaves the DIs be once
+// the gear is in.
+static void benchSimStep(const Scenario& scenario, const WorldMap& world, const BenchOptions& options, std::vector<BenchResult>& results) {
+    SimCore sim;
+    if (!sim.init(&world, scenario.entities, 1)) return;
+    Rng inputRng(2);
+    SimInput input;
+    results.push_back(measure("sim_step", scenario, options, [&]() {
+        if (sim.state().tick % 30 == 0) {
+            input.moveX = inputRng.below(3) - 1;
+            input.moveY = inputRng.below(3) - 1;
+            input.sprint = inputRng.below(2) == 0;
+        }
+        input.escape = sim.state().recruits.heldCount() > 0;
+        sim.step(input);
+    }, [&sim]() { return sim.state().gameOver || sim.state().gearCollected; }, [&]() { sim.init(&world, scenario.entities, 1); }));
+}
+
+// One particle update at a constant population: whatever fell out of view is respawned at the top
+static void benchParticleUpdate(const Scenario& scenario, const BenchOptions& options, std::vector<BenchResult>& results) {
+    ParticleSystem particles;
+    Rng rng(3);
+    SDL_Rect view = {0, 0, WIDTH, HEIGHT};
+    results.push_back(measure("particle_update", scenario, options, [&]() {
+        while (particles.size() < scenario.particles) {
+            if (!particles.spawn(Vector2(rng.below(WIDTH), rng.below(HEIGHT)))) break;
+        }
+        particles.update(view);
+    }));
+}
+
+// The per-frame HUD: three shadowed lines and a prompt, then one flush
+static void benchText(const Scenario& scenario, const BenchOptions& options, std::vector<BenchResult>& results) {
+    TTF_Font* font = TTF_OpenFont("sprites/DejaVuSans.ttf", 36);
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, WIDTH, HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    if (font && renderer) {
+        TextRenderer text(renderer, font);
+        int frame = 0;
+        results.push_back(measure("text_render", scenario, options, [&]() {
+            text.drawTextWithShadow("You look like the monkey off Ace Ventura!", BLACK, WHITE, 10, HEIGHT - 102);
+            text.drawTextWithShadow("Times Caught: " + std::to_string(frame++ % MAX_CATCHES) + "/" + std::to_string(MAX_CATCHES), BLACK, WHITE, 10, 40);
+            text.drawText("Press Space to Escape!", WHITE, 200, HEIGHT - 150);
+            text.flush();
+        }));
+    } else {
+        std::cerr << "text_render skipped: " << (font ? SDL_GetError() : TTF_GetError()) << std::endl;
+    }
+    if (renderer) SDL_DestroyRenderer(renderer);
+    if (target) SDL_FreeSurface(target);
+    if (font) TTF_CloseFont(font);
+}
+
+static bool writeJson(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    out << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"scenario\": \"" << r.scenario->name << "\", \"map_size\": " << r.scenario->mapSize
+            << ", \"structures\": " << r.scenario->structures << ", \"entities\": " << r.scenario->entities
+            << ", \"particles\": " << r.scenario->particles << ", \"iterations\": " << r.iterations << ", \"restarts\": " << r.restarts
+            << ", \"ns_per_op\": " << r.nsPerOp << ", \"ops_per_sec\": " << 1e9 / r.nsPerOp
+            << ", \"allocs_per_op\": " << r.allocsPerOp << ", \"bytes_per_op\": " << r.bytesPerOp << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quick") {
+            options.minSeconds = 0.1;
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            options.jsonPath = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--quick] [--filter NAME] [--json results.json]" << std::endl;
+            return 1;
+        }
+    }
+
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");  // Headless; everything draws through software renderers
+    if (SDL_Init(SDL_INIT_VIDEO) < 0 || TTF_Init() < 0) {
+        std::cerr << "Initialization failed: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    auto wanted = [&options](const char* name) { return options.filter.empty() || options.filter == name; };
+    std::vector<BenchResult> results;
+    for (const Scenario& scenario : SCENARIOS) {
+        WorldMap world;
+        if (!loadSyntheticMap(world, scenario)) {
+            std::cerr << "Could not generate the " << scenario.name << " map" << std::endl;
+            continue;
+        }
+        if (wanted("render_scene")) benchRenderScene(scenario, world, options, results);
+        if (wanted("sim_step")) benchSimStep(scenario, world, options, results);
+        if (wanted("particle_update")) benchParticleUpdate(scenario, options, results);
+        if (wanted("text_render") && &scenario == &SCENARIOS[0]) benchText(scenario, options, results);  // Independent of the map
+    }
+
+    std::printf("%-16s %-8s %12s %14s %14s %12s %12s\n", "benchmark", "scenario", "ops", "ns/op", "ops/s", "allocs/op", "bytes/op");
+    for (const BenchResult& r : results) {
+        std::printf("%-16s %-8s %12lld %14.0f %14.1f %12.2f %12.1f", r.name.c_str(), r.scenario->name, r.iterations, r.nsPerOp, 1e9 / r.nsPerOp,
+                    r.allocsPerOp, r.bytesPerOp);
+        if (r.restarts > 0) std::printf("  (games restarted: %lld)", r.restarts);
+        std::printf("\n");
+    }
+    if (!options.jsonPath.empty() && !writeJson(options.jsonPath, results)) {
+        std::cerr << "Could not write " << options.jsonPath << std::endl;
+    }
+
+    TTF_Quit();
+    SDL_Quit();
+    return 0;
+}
@@ -6,12 +6,19 @@
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_mixer.h>
 #include <ctime> // For time functions
+#include <cstddef>
 
 const int WIDTH = 800;
 const int HEIGHT = 600;
-const int MAP_WIDTH = 1600;  // Adjust based on map scale
-const int MAP_HEIGHT = 1200; // Adjust based on map scale
 const int SPRITE_SIZE = 32;
+const int MAP_CHUNK_SIZE = 512;  // Size of the pre-rendered map chunks cached by the Renderer
+const int MAP_CHUNK_BUDGET = 24;         // Chunk textures resident at once (1 MB each), least recently used evicted first
+const int MAP_CHUNK_PREFETCH = 256;      // Chunks this far outside the view are prepared ahead of the camera
+const int MAP_CHUNK_JOBS = 4;            // Chunks being prepared in the background at once
+const int MAP_CHUNK_UPLOADS_PER_FRAME = 1;  // Prepared chunks rendered into their texture per frame
+const int RECRUIT_FRAMES = 4;  // recruit_walk1..4 in the sprite atlas
+const int DI_FRAMES = 2;       // di_yell1..2 in the sprite atlas
+const int COLLISION_CELL_SIZE = 64;  // Cell size of the static collision grid
 
 // Colors (SDL uses RGB values 0-255)
 const SDL_Color SAND = {194, 178, 128, 255};    // Parris Island ground (day)
@@ -27,9 +34,42 @@ const SDL_Color GRASS = {0, 100, 0, 255};       // Rifle range
 const SDL_Color PAVEMENT = {255, 255, 255, 255}; // Parade deck
 const SDL_Color WATER = {0, 119, 190, 255};     // Teal for water bodies
 
+// Map structure categories, in the order movement resolves collisions against them
+enum StructureCategory {
+    CATEGORY_BARRACKS,
+    CATEGORY_OBSTACLE,
+    CATEGORY_SAND_PIT,
+    CATEGORY_RIFLE_RANGE,
+    CATEGORY_PARADE_DECK,
+    CATEGORY_CHOW_HALL,
+    CATEGORY_ROAD,
+    CATEGORY_WATER,
+    CATEGORY_COUNT
+};
+
+inline Uint32 categoryBit(StructureCategory category) { return 1u << category; }
+
+// Read-only view of a contiguous run of rects (e.g. a rect table inside the memory-mapped map)
+struct RectSpan {
+    const SDL_Rect* data = nullptr;
+    size_t count = 0;
+    const SDL_Rect* begin() const { return data; }
+    const SDL_Rect* end() const { return data + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const SDL_Rect& operator[](size_t i) const { return data[i]; }
+};
+
 struct Vector2 {
     float x, y;
     Vector2(float x_ = 0, float y_ = 0) : x(x_), y(y_) {}
 };
 
+inline Vector2 lerp(Vector2 a, Vector2 b, float t) { return Vector2(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t); }
+
+// Component-wise product, as SDL applies a texture color mod
+inline SDL_Color modulate(SDL_Color color, SDL_Color by) {
+    return {static_cast<Uint8>(color.r * by.r / 255), static_cast<Uint8>(color.g * by.g / 255), static_cast<Uint8>(color.b * by.b / 255), color.a};
+}
+
 #endif // COMMON_H
@@ -0,0 +1,105 @@
+#include "di_swarm.h"
+#include <cmath>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define DI_SWARM_SIMD 1
+#include <immintrin.h>
+#endif
+
+const int SWARM_LANES = 8;           // Arrays are padded to the widest kernel
+const float IDLE_POSITION = -1.0e9f; // Padding entries sit far off the map
+
+namespace {
+
+// Kernels work on [begin, end) and must produce bit-identical results: sqrt and division are
+// correctly rounded in every instruction set, and no reciprocal approximations are used.
+
+void chaseScalar(const float* dx, const float* dy, float* vx, float* vy, int begin, int end, float speed) {
+    for (int i = begin; i < end; ++i) {
+        float length = std::sqrt(dx[i] * dx[i] + dy[i] * dy[i]);
+        vx[i] = length != 0 ? (dx[i] / length) * speed : 0.0f;
+        vy[i] = length != 0 ? (dy[i] / length) * speed : 0.0f;
+    }
+}
+
+#ifdef DI_SWARM_SIMD
+__attribute__((target("sse2")))
+void chaseSSE2(const float* dx, const float* dy, float* vx, float* vy, int count, float speed) {
+    const __m128 zero = _mm_setzero_ps(), s = _mm_set1_ps(speed);
+    for (int i = 0; i < count; i += 4) {
+        __m128 x = _mm_loadu_ps(dx + i), y = _mm_loadu_ps(dy + i);
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+        __m128 moving = _mm_cmpneq_ps(length, zero);  // Zero-length headings would divide to NaN
+        _mm_storeu_ps(vx + i, _mm_and_ps(moving, _mm_mul_ps(_mm_div_ps(x, length), s)));
+        _mm_storeu_ps(vy + i, _mm_and_ps(moving, _mm_mul_ps(_mm_div_ps(y, length), s)));
+    }
+}
+
+__attribute__((target("avx2")))
+void chaseAVX2(const float* dx, const float* dy, float* vx, float* vy, int count, float speed) {
+    const __m256 zero = _mm256_setzero_ps(), s = _mm256_set1_ps(speed);
+    for (int i = 0; i < count; i += 8) {
+        __m256 x = _mm256_loadu_ps(dx + i), y = _mm256_loadu_ps(dy + i);
+        __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)));
+        __m256 moving = _mm256_cmp_ps(length, zero, _CMP_NEQ_UQ);
+        _mm256_storeu_ps(vx + i, _mm256_and_ps(moving, _mm256_mul_ps(_mm256_div_ps(x, length), s)));
+        _mm256_storeu_ps(vy + i, _mm256_and_ps(moving, _mm256_mul_ps(_mm256_div_ps(y, length), s)));
+    }
+}
+#endif
+
+enum SimdLevel { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 };
+
+SimdLevel simdLevel() {
+#ifdef DI_SWARM_SIMD
+    static const SimdLevel level = SDL_HasAVX2() ? SIMD_AVX2 : (SDL_HasSSE2() ? SIMD_SSE2 : SIMD_SCALAR);
+    return level;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+} // namespace
+
+void DrillInstructorSwarm::clear() {
+    posX.clear(); posY.clear();
+    velX.clear(); velY.clear();
+    dirX.clear(); dirY.clear();
+    latched.clear();
+    cooldown.clear();
+    count = 0;
+}
+
+int DrillInstructorSwarm::add(Vector2 pos) {
+    if (count == static_cast<int>(posX.size())) {
+        size_t padded = posX.size() + SWARM_LANES;  // Grow by a full lane group of idle entries
+        posX.resize(padded, IDLE_POSITION); posY.resize(padded, IDLE_POSITION);
+        velX.resize(padded, 0.0f); velY.resize(padded, 0.0f);
+        dirX.resize(padded, 0.0f); dirY.resize(padded, 0.0f);
+        latched.resize(padded, 1);  // Idle entries can never catch
+        cooldown.resize(padded, 0);
+    }
+    int i = count++;
+    posX[i] = pos.x;
+    posY[i] = pos.y;
+    latched[i] = 0;
+    return i;
+}
+
+// Normalize each heading and scale it to speed, writing this frame's step into the velocity arrays
+void DrillInstructorSwarm::computeChase(float speed) {
+    int padded = static_cast<int>(posX.size());
+    switch (simdLevel()) {
+#ifdef DI_SWARM_SIMD
+    case SIMD_AVX2: chaseAVX2(dirX.data(), dirY.data(), velX.data(), velY.data(), padded, speed); break;
+    case SIMD_SSE2: chaseSSE2(dirX.data(), dirY.data(), velX.data(), velY.data(), padded, speed); break;
+#endif
+    default: chaseScalar(dirX.data(), dirY.data(), velX.data(), velY.data(), 0, count, speed); break;
+    }
+}
+
+void DrillInstructorSwarm::tickCooldowns() {
+    for (int i = 0; i < count; ++i) {
+        if (cooldown[i] > 0) cooldown[i]--;
+    }
+}
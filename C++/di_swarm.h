@@ -0,0 +1,40 @@
+#ifndef DI_SWARM_H
+#define DI_SWARM_H
+
+#include "common.h"
+#include "archetypes.h"
+#include <vector>
+
+// Drill Instructor state in structure-of-arrays form, so the chase kernel can process
+// 4 (SSE2) or 8 (AVX2) DIs per instruction. Arrays are padded to a multiple of 8 with idle entries.
+class DrillInstructorSwarm {
+private:
+    std::vector<float> posX, posY;  // Top-left corner of each DI sprite
+    std::vector<float> velX, velY;  // Step for this frame, written by computeChase()
+    std::vector<float> dirX, dirY;  // Unnormalized heading, written by the caller before computeChase()
+    std::vector<int> latched;       // 1 while the DI holds the recruit (int so kernels can compare whole lanes)
+    std::vector<int> cooldown;      // Frames until this DI may catch again
+    int count = 0;
+
+public:
+    void clear();
+    int add(Vector2 pos);
+    int size() const { return count; }
+
+    Vector2 position(int i) const { return Vector2(posX[i], posY[i]); }
+    void setPosition(int i, Vector2 pos) { posX[i] = pos.x; posY[i] = pos.y; }
+    Vector2 velocity(int i) const { return Vector2(velX[i], velY[i]); }
+    void setHeading(int i, Vector2 dir) { dirX[i] = dir.x; dirY[i] = dir.y; }
+    bool isLatched(int i) const { return latched[i] != 0; }
+    void setLatched(int i, bool value) { latched[i] = value ? 1 : 0; }
+    void setCooldown(int i, int frames) { cooldown[i] = frames; }
+    bool canCatch(int i) const { return latched[i] == 0 && cooldown[i] <= 0; }
+    const float* xs() const { return posX.data(); }
+    const float* ys() const { return posY.data(); }
+    MoverArrays movers() { return {posX.data(), posY.data(), velX.data(), velY.data(), latched.data(), count}; }
+
+    void computeChase(float speed);
+    void tickCooldowns();
+};
+
+#endif // DI_SWARM_H
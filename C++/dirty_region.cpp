@@ -0,0 +1,67 @@
+#include "dirty_region.h"
+#include <algorithm>
+
+DirtyRegion::DirtyRegion(int width, int height)
+    : width(width), height(height), columns((width + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE), rows((height + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE),
+      tiles(columns * rows, 0) {}
+
+void DirtyRegion::add(const SDL_Rect& rect) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+    int firstCol = std::max(0, rect.x / DIRTY_TILE_SIZE);
+    int firstRow = std::max(0, rect.y / DIRTY_TILE_SIZE);
+    int lastCol = std::min(columns - 1, (rect.x + rect.w - 1) / DIRTY_TILE_SIZE);
+    int lastRow = std::min(rows - 1, (rect.y + rect.h - 1) / DIRTY_TILE_SIZE);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) {
+            Uint8& tile = tiles[row * columns + col];
+            dirtyTiles += 1 - tile;
+            tile = 1;
+        }
+    }
+    mergedValid = false;
+}
+
+void DirtyRegion::clear() {
+    std::fill(tiles.begin(), tiles.end(), 0);
+    dirtyTiles = 0;
+    merged.clear();
+    mergedValid = true;
+}
+
+void DirtyRegion::merge(const DirtyRegion& other) {
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        dirtyTiles += other.tiles[i] & (1 - tiles[i]);
+        tiles[i] |= other.tiles[i];
+    }
+    mergedValid = false;
+}
+
+const std::vector<SDL_Rect>& DirtyRegion::rects() {
+    if (mergedValid) return merged;
+    merged.clear();
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < columns;) {
+            if (!tiles[row * columns + col]) {
+                col++;
+                continue;
+            }
+            int start = col;
+            while (col < columns && tiles[row * columns + col]) col++;
+            SDL_Rect run = {start * DIRTY_TILE_SIZE, row * DIRTY_TILE_SIZE, (col - start) * DIRTY_TILE_SIZE, DIRTY_TILE_SIZE};
+            auto above = std::find_if(merged.begin(), merged.end(), [&run](const SDL_Rect& rect) {
+                return rect.x == run.x && rect.w == run.w && rect.y + rect.h == run.y;
+            });
+            if (above != merged.end()) {
+                above->h += DIRTY_TILE_SIZE;
+            } else {
+                merged.push_back(run);
+            }
+        }
+    }
+    for (SDL_Rect& rect : merged) {  // Edge tiles may hang past the screen
+        rect.w = std::min(rect.w, width - rect.x);
+        rect.h = std::min(rect.h, height - rect.y);
+    }
+    mergedValid = true;
+    return merged;
+}
@@ -0,0 +1,32 @@
+#ifndef DIRTY_REGION_H
+#define DIRTY_REGION_H
+
+#include "common.h"
+#include <vector>
+
+const int DIRTY_TILE_SIZE = 32;          // Damage is tracked per tile of the screen
+const float DIRTY_FULL_FRACTION = 0.5f;  // Past this share of the screen, one full repaint is cheaper than many small ones
+
+// Screen damage for one frame, kept as a bitmap of DIRTY_TILE_SIZE tiles so any number of small rects
+// (sprites, dust, glyph runs) collapses into a few tile-aligned ones: horizontal runs of dirty tiles,
+// merged with the run below when they line up.
+class DirtyRegion {
+private:
+    int width, height;
+    int columns, rows;
+    std::vector<Uint8> tiles;
+    int dirtyTiles = 0;
+    std::vector<SDL_Rect> merged;
+    bool mergedValid = true;
+
+public:
+    DirtyRegion(int width = WIDTH, int height = HEIGHT);
+    void add(const SDL_Rect& rect);  // Clipped to the screen
+    void clear();
+    void merge(const DirtyRegion& other);  // Same screen size only
+    bool empty() const { return dirtyTiles == 0; }
+    bool mostlyDirty() const { return dirtyTiles > DIRTY_FULL_FRACTION * columns * rows; }
+    const std::vector<SDL_Rect>& rects();
+};
+
+#endif // DIRTY_REGION_H
@@ -0,0 +1,48 @@
+#include "entity_grid.h"
+#include <algorithm>
+
+void EntityGrid::resize(int mapW, int mapH) {
+    columns = std::max(1, (mapW + cellSize - 1) / cellSize);
+    rows = std::max(1, (mapH + cellSize - 1) / cellSize);
+    cellStart.assign(columns * rows + 1, 0);
+    items.clear();
+    itemX.clear();
+    itemY.clear();
+}
+
+// Entities off the map are kept in the nearest edge cell, so they can still be found
+int EntityGrid::cellIndex(float x, float y) const {
+    int col = std::max(0, std::min(columns - 1, static_cast<int>(x) / cellSize));
+    int row = std::max(0, std::min(rows - 1, static_cast<int>(y) / cellSize));
+    return row * columns + col;
+}
+
+// Bucket every entity by cell (two passes: count, then fill in index order)
+void EntityGrid::rebuild(const float* xs, const float* ys, int count) {
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    cellOf.resize(count);
+    for (int i = 0; i < count; ++i) {
+        cellOf[i] = cellIndex(xs[i], ys[i]);
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (size_t c = 1; c < cellStart.size(); ++c) cellStart[c] += cellStart[c - 1];
+
+    items.resize(count);
+    itemX.resize(count);
+    itemY.resize(count);
+    for (int i = 0; i < count; ++i) {
+        int slot = cellStart[cellOf[i]]++;
+        items[slot] = i;
+        itemX[slot] = xs[i];
+        itemY[slot] = ys[i];
+    }
+    // The fill pass advanced every start to the next cell's start; shift them back
+    for (size_t c = cellStart.size() - 1; c > 0; --c) cellStart[c] = cellStart[c - 1];
+    cellStart[0] = 0;
+}
+
+bool EntityGrid::anyWithin(Vector2 center, float radius) const {
+    bool found = false;
+    forEachWithin(center, radius, [&found](int, float) { found = true; });
+    return found;
+}
@@ -0,0 +1,63 @@
+#ifndef ENTITY_GRID_H
+#define ENTITY_GRID_H
+
+#include "common.h"
+#include <algorithm>
+#include <vector>
+
+const int ENTITY_CELL_SIZE = 128;  // No smaller than the largest query radius, so a query visits at most 3x3 cells
+
+// Broad phase for moving entities and pickups: a uniform grid over the map, rebuilt from scratch
+// every tick with a counting sort (O(entities + cells), no allocation once warmed up). Each entity
+// sits in the one cell holding its position; radius queries visit the cells the circle overlaps and
+// compare squared distances, so N seekers against M targets cost about N local checks, not N*M.
+class EntityGrid {
+private:
+    int cellSize;
+    int columns = 0, rows = 0;
+    std::vector<int> cellStart;              // Offsets into the item arrays, one per cell plus a terminator
+    std::vector<int> cellOf;                 // Scratch: cell of each entity during rebuild()
+    std::vector<int> items;                  // Entity indices grouped by cell, ascending within a cell
+    std::vector<float> itemX, itemY;         // Their positions, in the same order
+
+    int cellIndex(float x, float y) const;
+
+public:
+    explicit EntityGrid(int cell = ENTITY_CELL_SIZE) : cellSize(cell) {}
+    void resize(int mapW, int mapH);
+    void rebuild(const float* xs, const float* ys, int count);
+
+    // Call visit(index, distanceSquared) for every entity closer than radius to center
+    template <typename Visit>
+    void forEachWithin(Vector2 center, float radius, Visit visit) const {
+        if (columns == 0) return;
+        const float r2 = radius * radius;
+        int firstCol = std::max(0, static_cast<int>((center.x - radius) / cellSize));
+        int lastCol = std::min(columns - 1, static_cast<int>((center.x + radius) / cellSize));
+        int firstRow = std::max(0, static_cast<int>((center.y - radius) / cellSize));
+        int lastRow = std::min(rows - 1, static_cast<int>((center.y + radius) / cellSize));
+        if (lastCol < firstCol || lastRow < firstRow) return;  // The circle lies wholly off the map
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int i = cellStart[row * columns + firstCol]; i < cellStart[row * columns + lastCol + 1]; ++i) {
+                float dx = center.x - itemX[i], dy = center.y - itemY[i];
+                float d2 = dx * dx + dy * dy;
+                if (d2 < r2) visit(items[i], d2);
+            }
+        }
+    }
+
+    // Lowest entity index within radius that accept(index) allows, or -1. Matches a linear scan in
+    // index order, so swapping one in for the other can't change which entity wins.
+    template <typename Accept>
+    int lowestWithin(Vector2 center, float radius, Accept accept) const {
+        int lowest = -1;
+        forEachWithin(center, radius, [&](int index, float) {
+            if ((lowest < 0 || index < lowest) && accept(index)) lowest = index;
+        });
+        return lowest;
+    }
+
+    bool anyWithin(Vector2 center, float radius) const;
+};
+
+#endif // ENTITY_GRID_H
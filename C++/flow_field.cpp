@@ -0,0 +1,129 @@
+#include "flow_field.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+const Uint32 FLOW_UNREACHABLE = 0xFFFFFFFFu;
+
+static const int NEIGHBOUR_DC[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+static const int NEIGHBOUR_DR[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+// Classify every cell from the static structures: blocking categories are walls, sand pits are slow
+void FlowField::build(const SpatialGrid& grid, int mapW, int mapH) {
+    columns = std::max(1, (mapW + FLOW_CELL_SIZE - 1) / FLOW_CELL_SIZE);
+    rows = std::max(1, (mapH + FLOW_CELL_SIZE - 1) / FLOW_CELL_SIZE);
+    cellCost.assign(columns * rows, 1);
+    distance.assign(columns * rows, FLOW_UNREACHABLE);
+    flowX.assign(columns * rows, 0.0f);
+    flowY.assign(columns * rows, 0.0f);
+    targetCells.clear();
+
+    const Uint32 wallMask = categoryBit(CATEGORY_BARRACKS) | categoryBit(CATEGORY_OBSTACLE) | categoryBit(CATEGORY_RIFLE_RANGE) |
+                            categoryBit(CATEGORY_PARADE_DECK) | categoryBit(CATEGORY_CHOW_HALL);
+    std::vector<int> nearby;
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < columns; ++col) {
+            SDL_Rect cell = {col * FLOW_CELL_SIZE, row * FLOW_CELL_SIZE, FLOW_CELL_SIZE, FLOW_CELL_SIZE};
+            grid.query(cell, wallMask | categoryBit(CATEGORY_SAND_PIT), nearby);
+            for (int index : nearby) {
+                const GridEntry& structure = grid.entry(index);
+                if (!SDL_HasIntersection(&cell, &structure.rect)) continue;
+                if (structure.category == CATEGORY_SAND_PIT) {
+                    if (cellCost[row * columns + col] != 0) cellCost[row * columns + col] = FLOW_SAND_FACTOR;
+                } else {
+                    cellCost[row * columns + col] = 0;
+                }
+            }
+        }
+    }
+}
+
+int FlowField::cellAt(Vector2 pos) const {
+    if (columns == 0) return -1;
+    int col = std::max(0, std::min(columns - 1, static_cast<int>(pos.x) / FLOW_CELL_SIZE));
+    int row = std::max(0, std::min(rows - 1, static_cast<int>(pos.y) / FLOW_CELL_SIZE));
+    return row * columns + col;
+}
+
+// A step is allowed into open cells only, and diagonals may not cut the corner of a wall
+bool FlowField::canStep(int col, int row, int dc, int dr) const {
+    int nc = col + dc, nr = row + dr;
+    if (nc < 0 || nr < 0 || nc >= columns || nr >= rows || cellCost[nr * columns + nc] == 0) return false;
+    if (dc != 0 && dr != 0) {
+        return cellCost[row * columns + nc] != 0 && cellCost[nr * columns + col] != 0;
+    }
+    return true;
+}
+
+// Recompute the field when the targets no longer cover the same cells. Returns true if it was rebuilt.
+bool FlowField::update(const Vector2* targets, int count) {
+    if (columns == 0 || count == 0) return false;
+    nextTargets.clear();
+    for (int i = 0; i < count; ++i) nextTargets.push_back(cellAt(targets[i]));
+    std::sort(nextTargets.begin(), nextTargets.end());
+    nextTargets.erase(std::unique(nextTargets.begin(), nextTargets.end()), nextTargets.end());
+    if (nextTargets == targetCells) return false;
+    targetCells.swap(nextTargets);
+    rebuild();
+    return true;
+}
+
+// Dijkstra outward from all target cells at once, then point every cell at its cheapest neighbour
+void FlowField::rebuild() {
+    std::fill(distance.begin(), distance.end(), FLOW_UNREACHABLE);
+    frontier.clear();
+    auto later = std::greater<std::pair<Uint32, int>>();
+    for (int cell : targetCells) {
+        distance[cell] = 0;
+        frontier.push_back({0, cell});
+    }
+    std::make_heap(frontier.begin(), frontier.end(), later);
+    while (!frontier.empty()) {
+        std::pop_heap(frontier.begin(), frontier.end(), later);
+        std::pair<Uint32, int> current = frontier.back();
+        frontier.pop_back();
+        if (current.first != distance[current.second]) continue;  // Stale entry
+        int col = current.second % columns, row = current.second / columns;
+        for (int n = 0; n < 8; ++n) {
+            if (!canStep(col, row, NEIGHBOUR_DC[n], NEIGHBOUR_DR[n])) continue;
+            int next = (row + NEIGHBOUR_DR[n]) * columns + col + NEIGHBOUR_DC[n];
+            // Paths run from the chaser to the target, so pay for the cell the chaser is leaving
+            Uint32 base = n < 4 ? FLOW_STEP_COST : FLOW_STEP_COST * 14 / 10;
+            Uint32 cost = current.first + base * std::max<Uint32>(1, cellCost[next]);
+            if (cost < distance[next]) {
+                distance[next] = cost;
+                frontier.push_back({cost, next});
+                std::push_heap(frontier.begin(), frontier.end(), later);
+            }
+        }
+    }
+
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < columns; ++col) {
+            int cell = row * columns + col;
+            flowX[cell] = 0.0f;
+            flowY[cell] = 0.0f;
+            if (cellCost[cell] == 0 || distance[cell] == FLOW_UNREACHABLE || distance[cell] == 0) continue;  // Walls, cut off, targets
+            Uint32 best = distance[cell];
+            for (int n = 0; n < 8; ++n) {
+                if (!canStep(col, row, NEIGHBOUR_DC[n], NEIGHBOUR_DR[n])) continue;
+                Uint32 d = distance[(row + NEIGHBOUR_DR[n]) * columns + col + NEIGHBOUR_DC[n]];
+                if (d < best) {
+                    best = d;
+                    float length = (n < 4) ? 1.0f : std::sqrt(2.0f);
+                    flowX[cell] = NEIGHBOUR_DC[n] / length;
+                    flowY[cell] = NEIGHBOUR_DR[n] / length;
+                }
+            }
+        }
+    }
+}
+
+// Heading at pos (use the sprite center). Returns false where the field has nothing to say:
+// in a target cell, inside walls, or where no target can be reached.
+bool FlowField::sample(Vector2 pos, Vector2* heading) const {
+    int cell = cellAt(pos);
+    if (cell < 0 || (flowX[cell] == 0.0f && flowY[cell] == 0.0f)) return false;
+    *heading = Vector2(flowX[cell], flowY[cell]);
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include "common.h"
+#include "spatial_grid.h"
+#include <vector>
+
+const int FLOW_CELL_SIZE = 32;       // One sprite per cell
+const Uint32 FLOW_STEP_COST = 10;    // Orthogonal step over open ground (diagonals cost 14)
+const Uint32 FLOW_SAND_FACTOR = 2;   // Sand pits are twice as expensive to cross
+
+// Shortest-path field toward the nearest of a set of targets, shared by every chaser. The field is
+// rebuilt only when a target moves to another cell; chasers then read their heading from it in O(1).
+class FlowField {
+private:
+    int columns = 0, rows = 0;
+    std::vector<Uint8> cellCost;     // 0 = wall, otherwise cost multiplier of entering the cell
+    std::vector<Uint32> distance;    // Path cost from each cell to the target cell
+    std::vector<float> flowX, flowY; // Unit heading toward the cheapest neighbour, (0, 0) at a target or if unreachable
+    std::vector<std::pair<Uint32, int>> frontier;  // Heap storage reused between rebuilds
+    std::vector<int> targetCells;    // Sorted, without duplicates
+    std::vector<int> nextTargets;    // Scratch for update()
+
+    int cellAt(Vector2 pos) const;
+    bool canStep(int col, int row, int dc, int dr) const;
+    void rebuild();
+
+public:
+    void build(const SpatialGrid& grid, int mapW, int mapH);
+    bool update(const Vector2* targets, int count);
+    bool sample(Vector2 pos, Vector2* heading) const;
+};
+
+#endif // FLOW_FIELD_H
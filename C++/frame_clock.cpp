@@ -0,0 +1,58 @@
+#include "frame_clock.h"
+#include <algorithm>
+#include <cmath>
+
+const Uint32 SPIN_MARGIN_MS = 2;  // SDL_Delay can oversleep by a millisecond or two, spin for the rest
+
+FrameClock::FrameClock(int tickRate) {
+    frequency = SDL_GetPerformanceFrequency();
+    tickLength = std::max<Uint64>(1, frequency / std::max(1, tickRate));
+    lastCounter = SDL_GetPerformanceCounter();
+}
+
+void FrameClock::setPacing(FramePacing mode, int targetFps) {
+    pacing = mode;
+    frameLength = std::max<Uint64>(1, frequency / std::max(1, targetFps));
+    nextFrame = 0;
+}
+
+// Forget time spent outside the loop (loading, blocking dialogs) so it isn't simulated
+void FrameClock::reset() {
+    lastCounter = SDL_GetPerformanceCounter();
+    accumulator = 0;
+    nextFrame = 0;
+}
+
+// Number of simulation ticks due since the last call. A long stall runs at most MAX_TICKS_PER_FRAME
+// ticks (scaled with the time scale) and drops the rest, so one slow frame can't snowball into ever
+// longer catch-up frames.
+int FrameClock::advance() {
+    Uint64 now = SDL_GetPerformanceCounter();
+    accumulator += timeScale == 1.0 ? now - lastCounter : static_cast<Uint64>((now - lastCounter) * timeScale);
+    lastCounter = now;
+    Uint64 ticks = accumulator / tickLength;
+    Uint64 maxTicks = static_cast<Uint64>(MAX_TICKS_PER_FRAME * std::max(1.0, std::ceil(timeScale)));
+    if (ticks > maxTicks) {
+        ticks = maxTicks;
+        accumulator = ticks * tickLength + accumulator % tickLength;
+    }
+    accumulator -= ticks * tickLength;
+    return static_cast<int>(ticks);
+}
+
+// In PACING_TARGET, block until the next frame deadline. Deadlines advance by a fixed step so the
+// frame rate doesn't drift; if we fall more than a frame behind, the schedule restarts from now.
+void FrameClock::waitForNextFrame() {
+    if (pacing != PACING_TARGET) return;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (nextFrame == 0 || now >= nextFrame + frameLength) {
+        nextFrame = now + frameLength;
+        return;
+    }
+    while (now < nextFrame) {
+        Uint32 remainingMs = static_cast<Uint32>((nextFrame - now) * 1000 / frequency);
+        if (remainingMs > SPIN_MARGIN_MS) SDL_Delay(remainingMs - SPIN_MARGIN_MS);
+        now = SDL_GetPerformanceCounter();
+    }
+    nextFrame += frameLength;
+}
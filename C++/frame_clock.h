@@ -0,0 +1,40 @@
+#ifndef FRAME_CLOCK_H
+#define FRAME_CLOCK_H
+
+#include "common.h"
+
+const int SIM_TICK_RATE = 60;       // Simulation ticks per second; all speeds are per tick
+const int MAX_TICKS_PER_FRAME = 5;  // Backlog beyond this is dropped instead of simulated
+
+enum FramePacing {
+    PACING_VSYNC,     // SDL_RenderPresent waits for the display
+    PACING_UNCAPPED,  // Render as fast as possible
+    PACING_TARGET     // Sleep, then spin, until the next frame deadline
+};
+
+// Fixed-timestep clock on SDL_GetPerformanceCounter. advance() turns the real time since the last
+// frame into whole simulation ticks and keeps the remainder, which alpha() exposes for interpolating
+// between the previous and current simulation states when rendering.
+class FrameClock {
+private:
+    Uint64 frequency;
+    Uint64 tickLength;       // Counter units per simulation tick
+    Uint64 lastCounter;
+    Uint64 accumulator = 0;  // Real time not yet simulated
+    FramePacing pacing = PACING_VSYNC;
+    Uint64 frameLength = 0;  // Counter units per frame in PACING_TARGET
+    Uint64 nextFrame = 0;    // Deadline of the next frame in PACING_TARGET
+    double timeScale = 1.0;  // Simulated time per real time, for fast or slow replays
+
+public:
+    explicit FrameClock(int tickRate = SIM_TICK_RATE);
+    void setPacing(FramePacing mode, int targetFps = SIM_TICK_RATE);
+    FramePacing getPacing() const { return pacing; }
+    void setTimeScale(double scale) { timeScale = scale > 0.0 ? scale : 1.0; }
+    void reset();
+    int advance();
+    float alpha() const { return static_cast<float>(static_cast<double>(accumulator) / tickLength); }
+    void waitForNextFrame();
+};
+
+#endif // FRAME_CLOCK_H
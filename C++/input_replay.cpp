@@ -0,0 +1,207 @@
+#include "input_replay.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+static void putBytes(std::vector<Uint8>& out, Uint64 value, int count) {
+    for (int i = 0; i < count; ++i) out.push_back(static_cast<Uint8>(value >> (8 * i)));
+}
+
+static void putVarint(std::vector<Uint8>& out, Uint32 value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<Uint8>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<Uint8>(value));
+}
+
+static Uint32 floatBits(float value) {
+    Uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Bounds-checked little-endian reader over a loaded file
+struct ReplayReader {
+    const std::vector<Uint8>& data;
+    size_t pos = 0;
+    bool ok = true;
+
+    Uint64 bytes(int count) {
+        Uint64 value = 0;
+        if (pos + count > data.size()) { ok = false; return 0; }
+        for (int i = 0; i < count; ++i) value |= static_cast<Uint64>(data[pos++]) << (8 * i);
+        return value;
+    }
+    Uint32 varint() {
+        Uint32 value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            Uint8 byte = static_cast<Uint8>(bytes(1));
+            value |= static_cast<Uint32>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        ok = false;
+        return 0;
+    }
+    float real() {
+        Uint32 bits = static_cast<Uint32>(bytes(4));
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+Uint8 InputReplay::pack(const SimInput& input) {
+    return static_cast<Uint8>((input.moveX + 1) | ((input.moveY + 1) << 2) | (input.sprint ? 16 : 0) | (input.escape ? 32 : 0));
+}
+
+SimInput InputReplay::unpack(Uint8 bits) {
+    SimInput input;
+    input.moveX = (bits & 3) - 1;
+    input.moveY = ((bits >> 2) & 3) - 1;
+    input.sprint = (bits & 16) != 0;
+    input.escape = (bits & 32) != 0;
+    return input;
+}
+
+void InputReplay::start(Uint64 seed, int drillInstructorCount, int recruitCount, int objectiveCount) {
+    sessionSeed = seed;
+    diCount = drillInstructorCount;
+    platoonSize = recruitCount;
+    objectives = objectiveCount;
+    runs.clear();
+    totalTicks = 0;
+    end = ReplayEndState();
+    rewind();
+}
+
+void InputReplay::record(const SimInput& input) {
+    Uint8 bits = pack(input);
+    if (!runs.empty() && runs.back().input == bits && runs.back().length < 0xffffffffu) runs.back().length++;
+    else runs.push_back({bits, 1});
+    totalTicks++;
+}
+
+ReplayEndState InputReplay::capture(const SimCore& sim) {
+    const SimState& state = sim.state();
+    ReplayEndState captured;
+    captured.checksum = sim.checksum();
+    captured.tick = state.tick;
+    captured.catchCount = state.catchCount;
+    captured.recruitX = state.recruits.position(0).x;
+    captured.recruitY = state.recruits.position(0).y;
+    captured.gearCollected = state.gearCollected;
+    captured.gameOver = state.gameOver;
+    return captured;
+}
+
+bool InputReplay::save(const std::string& path) const {
+    std::vector<Uint8> out;
+    putBytes(out, REPLAY_MAGIC, 4);
+    putBytes(out, REPLAY_VERSION, 4);
+    putBytes(out, sessionSeed, 8);
+    putBytes(out, static_cast<Uint32>(diCount), 4);
+    putBytes(out, static_cast<Uint32>(platoonSize), 4);
+    putBytes(out, static_cast<Uint32>(objectives), 4);
+    putBytes(out, end.checksum, 8);
+    putBytes(out, static_cast<Uint32>(end.tick), 4);
+    putBytes(out, static_cast<Uint32>(end.catchCount), 4);
+    putBytes(out, floatBits(end.recruitX), 4);
+    putBytes(out, floatBits(end.recruitY), 4);
+    putBytes(out, (end.gearCollected ? 1 : 0) | (end.gameOver ? 2 : 0), 1);
+    putVarint(out, static_cast<Uint32>(runs.size()));
+    for (const auto& run : runs) {
+        out.push_back(run.input);
+        putVarint(out, run.length);
+    }
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(out.data()), out.size());
+    if (!file) {
+        std::cerr << "Failed to write replay " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool InputReplay::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Replay not found: " << path << std::endl;
+        return false;
+    }
+    std::vector<Uint8> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ReplayReader in = {data};
+    Uint32 magic = static_cast<Uint32>(in.bytes(4));
+    Uint32 version = static_cast<Uint32>(in.bytes(4));
+    if (magic != REPLAY_MAGIC || version < REPLAY_OLDEST_VERSION || version > REPLAY_VERSION) {
+        std::cerr << "Not a version " << REPLAY_OLDEST_VERSION << "-" << REPLAY_VERSION << " replay: " << path << std::endl;
+        return false;
+    }
+    Uint64 seed = in.bytes(8);
+    Sint32 drillInstructorCount = static_cast<Sint32>(in.bytes(4));
+    Sint32 recruitCount = version >= 3 ? static_cast<Sint32>(in.bytes(4)) : 1;
+    Sint32 objectiveCount = version >= 3 ? static_cast<Sint32>(in.bytes(4)) : 1;
+    start(seed, drillInstructorCount, recruitCount, objectiveCount);
+    if (drillInstructorCount < 1 || drillInstructorCount > MAX_DRILL_INSTRUCTORS || recruitCount < 1 || recruitCount > MAX_RECRUITS ||
+        objectiveCount < 1 || objectiveCount > MAX_OBJECTIVES) {
+        in.ok = false;  // Out of the range the command line accepts, so corrupt rather than a session to replay
+    }
+    if (in.ok && version < 4 && recruitCount > 1) {
+        std::cerr << "Replay recorded before DIs chased the whole platoon, it no longer plays the same: " << path << std::endl;
+        return false;
+    }
+    end.checksum = in.bytes(8);
+    end.tick = static_cast<Sint32>(in.bytes(4));
+    end.catchCount = static_cast<Sint32>(in.bytes(4));
+    end.recruitX = in.real();
+    end.recruitY = in.real();
+    Uint8 flags = static_cast<Uint8>(in.bytes(1));
+    end.gearCollected = (flags & 1) != 0;
+    end.gameOver = (flags & 2) != 0;
+    Uint32 runCount = in.varint();
+    for (Uint32 i = 0; i < runCount && in.ok; ++i) {
+        Uint8 input = static_cast<Uint8>(in.bytes(1));
+        Uint32 length = in.varint();
+        if (length == 0 || totalTicks + static_cast<Uint64>(length) > 0x7fffffff) in.ok = false;
+        runs.push_back({input, length});
+        totalTicks += length;
+    }
+    if (!in.ok || in.pos != data.size()) {
+        std::cerr << "Corrupt replay: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool InputReplay::next(SimInput& input) {
+    if (playRun >= runs.size()) return false;
+    input = unpack(runs[playRun].input);
+    if (++playTick == runs[playRun].length) {
+        playRun++;
+        playTick = 0;
+    }
+    return true;
+}
+
+bool InputReplay::verify(const SimCore& sim) const {
+    ReplayEndState actual = capture(sim);
+    bool ok = true;
+    auto check = [&ok](const char* field, bool same, double expected, double got) {
+        if (!same) {
+            std::cerr << "Replay mismatch in " << field << ": expected " << expected << ", got " << got << std::endl;
+            ok = false;
+        }
+    };
+    check("tick", actual.tick == end.tick, end.tick, actual.tick);
+    check("catchCount", actual.catchCount == end.catchCount, end.catchCount, actual.catchCount);
+    check("recruitPos.x", floatBits(actual.recruitX) == floatBits(end.recruitX), end.recruitX, actual.recruitX);
+    check("recruitPos.y", floatBits(actual.recruitY) == floatBits(end.recruitY), end.recruitY, actual.recruitY);
+    check("gearCollected", actual.gearCollected == end.gearCollected, end.gearCollected, actual.gearCollected);
+    check("gameOver", actual.gameOver == end.gameOver, end.gameOver, actual.gameOver);
+    if (actual.checksum != end.checksum) {
+        std::cerr << "Replay mismatch in checksum: expected " << std::hex << end.checksum << ", got " << actual.checksum << std::dec << std::endl;
+        ok = false;
+    }
+    return ok;
+}
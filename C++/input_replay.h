@@ -0,0 +1,64 @@
+#ifndef INPUT_REPLAY_H
+#define INPUT_REPLAY_H
+
+#include "common.h"
+#include "sim_core.h"
+#include <string>
+#include <vector>
+
+const Uint32 REPLAY_MAGIC = 0x50524950;  // "PIRP" little-endian
+const Uint32 REPLAY_VERSION = 4;  // 4: DIs chase the whole platoon; 3: platoon and objective counts; 2: walking animation every 10th tick
+const Uint32 REPLAY_OLDEST_VERSION = 2;  // Older sessions play the same with one recruit, version 2 ones with one objective too
+
+// What a session ended with; playback must reproduce it exactly
+struct ReplayEndState {
+    Uint64 checksum = 0;
+    Sint32 tick = 0, catchCount = 0;
+    float recruitX = 0.0f, recruitY = 0.0f;
+    bool gearCollected = false, gameOver = false;
+};
+
+// One SimInput per tick, stored as runs of identical inputs. Each input packs into a byte
+// (two bits per axis, sprint, escape) and each run is that byte plus a varint length, so a few
+// minutes of play usually take a few kilobytes. The seed, entity counts and end state travel with it.
+class InputReplay {
+private:
+    struct Run {
+        Uint8 input;
+        Uint32 length;
+    };
+    Uint64 sessionSeed = 0;
+    Sint32 diCount = 1;
+    Sint32 platoonSize = 1;
+    Sint32 objectives = 1;
+    std::vector<Run> runs;
+    int totalTicks = 0;
+    ReplayEndState end;
+    size_t playRun = 0;   // Playback position
+    Uint32 playTick = 0;  // Ticks already played from runs[playRun]
+
+    static Uint8 pack(const SimInput& input);
+    static SimInput unpack(Uint8 bits);
+
+public:
+    void start(Uint64 seed, int drillInstructorCount, int recruitCount = 1, int objectiveCount = 1);
+    void record(const SimInput& input);
+    void finish(const SimCore& sim) { end = capture(sim); }
+    bool save(const std::string& path) const;
+
+    bool load(const std::string& path);
+    void rewind() { playRun = 0; playTick = 0; }
+    bool next(SimInput& input);  // False once every recorded tick has been played
+    bool finished() const { return playRun >= runs.size(); }
+    bool verify(const SimCore& sim) const;  // Compare the end state, reporting differences on std::cerr
+
+    Uint64 seed() const { return sessionSeed; }
+    int drillInstructorCount() const { return diCount; }
+    int recruitCount() const { return platoonSize; }
+    int objectiveCount() const { return objectives; }
+    int tickCount() const { return totalTicks; }
+    const ReplayEndState& endState() const { return end; }
+    static ReplayEndState capture(const SimCore& sim);
+};
+
+#endif // INPUT_REPLAY_H
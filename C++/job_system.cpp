@@ -0,0 +1,105 @@
+#include "job_system.h"
+#include <algorithm>
+
+static thread_local const JobSystem* currentSystem = nullptr;  // Pool the calling thread works for, if any
+static thread_local int currentQueue = 0;
+
+JobSystem::JobSystem(int workerCount) {
+    if (workerCount < 0) workerCount = std::min(JOB_MAX_WORKERS, std::max(0, SDL_GetCPUCount() - 1));
+    for (int i = 0; i <= workerCount; ++i) queues.emplace_back(new Queue());
+    for (int i = 1; i <= workerCount; ++i) workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+int JobSystem::ownQueue() const {
+    return currentSystem == this ? currentQueue : 0;
+}
+
+void JobSystem::submit(Job job, JobCounter& counter) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    if (workers.empty()) {  // No pool: run inline
+        job();
+        counter.pending.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+    Queue& queue = *queues[ownQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back({std::move(job), &counter});
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    { std::lock_guard<std::mutex> lock(sleepMutex); }  // Pairs with the predicate check in workerLoop, so the wake-up isn't lost
+    wake.notify_one();
+}
+
+bool JobSystem::popJob(int queueIndex, QueuedJob& out, bool steal) {
+    Queue& queue = *queues[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) return false;
+    if (steal) {
+        out = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+    } else {
+        out = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+    }
+    return true;
+}
+
+// Run one job: our own newest first, otherwise the oldest job of another queue
+bool JobSystem::runOne() {
+    if (queued.load(std::memory_order_acquire) == 0) return false;
+    int own = ownQueue();
+    QueuedJob job;
+    bool found = popJob(own, job, false);
+    for (size_t i = 1; !found && i < queues.size(); ++i) found = popJob((own + i) % queues.size(), job, true);
+    if (!found) return false;
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    job.job();
+    job.counter->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::workerLoop(int queue) {
+    currentSystem = this;
+    currentQueue = queue;
+    while (true) {
+        if (runOne()) continue;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping) return;
+    }
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    while (!counter.done()) {
+        if (!runOne()) std::this_thread::yield();
+    }
+}
+
+// Split [0, count) into ranges of at least grain items, run them across the pool and join them
+void JobSystem::parallelFor(int count, int grain, const std::function<void(int begin, int end)>& body) {
+    if (count <= 0) return;
+    grain = std::max(grain, 1);
+    int ranges = std::min((count + grain - 1) / grain, 4 * threadCount());  // A few ranges per thread for stealing to balance
+    if (ranges <= 1 || workers.empty()) {
+        body(0, count);
+        return;
+    }
+    JobCounter counter;
+    for (int r = 1; r < ranges; ++r) {
+        int begin = static_cast<int>(static_cast<long long>(count) * r / ranges);
+        int end = static_cast<int>(static_cast<long long>(count) * (r + 1) / ranges);
+        submit([&body, begin, end] { body(begin, end); }, counter);
+    }
+    body(0, static_cast<int>(static_cast<long long>(count) / ranges));  // The first range on this thread
+    wait(counter);
+}
@@ -0,0 +1,62 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "common.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const int JOB_MAX_WORKERS = 15;  // Beyond this the per-frame work is too small to split further
+
+typedef std::function<void()> Job;
+
+// Counts jobs that have not finished yet; wait() on it to join them
+struct JobCounter {
+    std::atomic<int> pending{0};
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Work-stealing thread pool for the frame's independent work. Every thread has its own deque: it
+// pushes and pops its own jobs at the back (newest first, still warm in cache) and idle threads steal
+// from the front of the others. Threads that wait() on a counter run jobs instead of blocking, so
+// jobs can submit and wait on sub-jobs without deadlocking the pool.
+class JobSystem {
+private:
+    struct QueuedJob {
+        Job job;
+        JobCounter* counter;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<QueuedJob> jobs;
+    };
+    std::vector<std::unique_ptr<Queue>> queues;  // [0] for threads outside the pool, then one per worker
+    std::vector<std::thread> workers;
+    std::atomic<int> queued{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+
+    int ownQueue() const;
+    bool popJob(int queue, QueuedJob& out, bool steal);
+    bool runOne();
+    void workerLoop(int queue);
+
+public:
+    explicit JobSystem(int workerCount = -1);  // -1: one worker per core besides the calling thread
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void submit(Job job, JobCounter& counter);
+    void wait(JobCounter& counter);  // Help with queued jobs until counter reaches zero
+    void parallelFor(int count, int grain, const std::function<void(int begin, int end)>& body);
+    int threadCount() const { return static_cast<int>(workers.size()) + 1; }
+};
+
+#endif // JOB_SYSTEM_H
@@ -0,0 +1,62 @@
+#include "lighting.h"
+#include <algorithm>
+
+static Uint8 mix(Uint8 from, Uint8 to, float t) {
+    return static_cast<Uint8>((1 - t) * from + t * to);
+}
+
+static SDL_Color mix(SDL_Color from, SDL_Color to, float t) {
+    return {mix(from.r, to.r, t), mix(from.g, to.g, t), mix(from.b, to.b, t), 255};
+}
+
+Lighting::Lighting() {
+    for (int i = 0; i < LIGHTING_LEVELS; ++i) {
+        float t = static_cast<float>(i) / (LIGHTING_LEVELS - 1);
+        table[i] = {mix(SAND, NIGHT, t), mix(WHITE, NIGHT_AMBIENT, t)};
+    }
+}
+
+// Darkness at an hour of the day (e.g. 14:30 = 14.5): 0 at 6 AM, 1 at 6 PM, easing back to 0 at midnight
+float Lighting::factorAt(float hour) {
+    // Define day/night periods (6 AM to 6 PM day, 6 PM to 6 AM night)
+    float sunrise = 6.0f;
+    float sunset = 18.0f;
+    float t;
+
+    if (hour >= sunrise && hour < sunset) {
+        // Daytime: interpolate from night (t=1) to day (t=0)
+        t = (hour - sunrise) / (sunset - sunrise);
+        t = 1.0f - t; // Reverse so 6 AM is full day (t=0), 6 PM is full night (t=1)
+    } else {
+        // Nighttime: interpolate across night period
+        float night_hours = (hour < sunrise) ? (hour + 24 - sunset) : (hour - sunset);
+        t = night_hours / (24.0f - (sunset - sunrise));
+        t = (t < 0.5f) ? 1.0f : 1.0f - ((t - 0.5f) * 2); // Smooth transition: 1 at 6 PM, 0 at midnight, 1 at 6 AM
+    }
+
+    return std::max(0.0f, std::min(1.0f, t)); // Clamp between 0 and 1
+}
+
+const LightLevel& Lighting::update(Uint32 now) {
+    if (sampled && !SDL_TICKS_PASSED(now, lastSample + LIGHTING_SAMPLE_MS)) return table[level];
+    sampled = true;
+    lastSample = now;
+
+    // Current time in EST, from UTC so the result doesn't depend on the machine's time zone
+    time_t clock = time(nullptr);
+    struct tm utc;
+#ifdef _WIN32
+    gmtime_s(&utc, &clock);
+#else
+    gmtime_r(&clock, &utc);
+#endif
+    int hour = (utc.tm_hour + LIGHTING_UTC_OFFSET + 24) % 24;
+    float t = factorAt(hour + utc.tm_min / 60.0f);
+    level = static_cast<int>(t * (LIGHTING_LEVELS - 1) + 0.5f);
+    return table[level];
+}
+
+const LightLevel& Lighting::at(float factor) const {
+    factor = std::max(0.0f, std::min(1.0f, factor));
+    return table[static_cast<int>(factor * (LIGHTING_LEVELS - 1) + 0.5f)];
+}
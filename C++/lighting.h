@@ -0,0 +1,35 @@
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+#include "common.h"
+
+const int LIGHTING_LEVELS = 64;            // Darkness steps in the tint table; finer than the eye follows at this pace
+const Uint32 LIGHTING_SAMPLE_MS = 30000;   // How often the wall clock is read; the cycle moves ~1% per 7 minutes
+const int LIGHTING_UTC_OFFSET = -5;        // Parris Island runs on EST
+const SDL_Color NIGHT_AMBIENT = {110, 120, 170, 255};  // Modulation of the lit layers at full night
+
+// Colors for one darkness step
+struct LightLevel {
+    SDL_Color background;  // Ground fill, SAND by day to NIGHT
+    SDL_Color ambient;     // Color mod for the map and sprites, WHITE by day to NIGHT_AMBIENT
+};
+
+// Day/night lighting. The darkness factor comes from the wall clock, which is only read every
+// LIGHTING_SAMPLE_MS; in between the renderer gets the cached entry of a table built once at
+// construction, so a frame costs no time() call and no color math.
+class Lighting {
+private:
+    LightLevel table[LIGHTING_LEVELS];
+    int level = 0;
+    Uint32 lastSample = 0;
+    bool sampled = false;
+
+    static float factorAt(float hour);
+
+public:
+    Lighting();
+    const LightLevel& update(Uint32 now);      // Follow the clock, resampling it when due
+    const LightLevel& at(float factor) const;  // Fixed darkness, 0 = full day, 1 = full night
+};
+
+#endif // LIGHTING_H
@@ -0,0 +1,168 @@
+// map_compiler.cpp
+// Offline tool: compiles a text map source (see maps/parris_island.txt) into the binary .pim format
+// loaded by WorldMap. Adjacent or overlapping rects of the same category are merged into a minimal set.
+//
+// The game only loads the compiled map, which is not checked in: 'make' builds this tool and runs it
+// as below whenever the source changes. By hand:
+//
+//   g++ -std=c++17 -O2 map_compiler.cpp -o map_compiler
+//   ./map_compiler maps/parris_island.txt maps/parris_island.pim
+#include "map_format.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct SourceMap {
+    int width = 0, height = 0;
+    std::vector<MapFileRect> rects[MAP_FILE_CATEGORY_COUNT];
+    std::string textures[MAP_FILE_CATEGORY_COUNT];
+};
+
+static int categoryIndex(const std::string& name) {
+    for (uint32_t i = 0; i < MAP_FILE_CATEGORY_COUNT; ++i) {
+        if (name == MAP_CATEGORY_NAMES[i]) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+static bool parseSource(const std::string& path, SourceMap& map) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword)) continue;  // Blank or comment
+
+        bool ok = true;
+        if (keyword == "size") {
+            ok = static_cast<bool>(words >> map.width >> map.height) && map.width > 0 && map.height > 0;
+        } else if (keyword == "texture") {
+            std::string name, texture;
+            int category = (words >> name >> texture) ? categoryIndex(name) : -1;
+            ok = category >= 0;
+            if (ok) map.textures[category] = texture;
+        } else {
+            int category = categoryIndex(keyword);
+            MapFileRect rect;
+            ok = category >= 0 && (words >> rect.x >> rect.y >> rect.w >> rect.h) && rect.w > 0 && rect.h > 0;
+            if (ok) map.rects[category].push_back(rect);
+        }
+        if (!ok) {
+            std::cerr << path << ":" << lineNumber << ": cannot parse \"" << line << "\"" << std::endl;
+            return false;
+        }
+    }
+    if (map.width <= 0 || map.height <= 0) {
+        std::cerr << path << ": missing \"size\" line" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool contains(const MapFileRect& outer, const MapFileRect& inner) {
+    return inner.x >= outer.x && inner.y >= outer.y &&
+           inner.x + inner.w <= outer.x + outer.w && inner.y + inner.h <= outer.y + outer.h;
+}
+
+// Union of a and b if together they form exactly one rectangle (shared edge or overlap along one axis)
+static bool tryMerge(const MapFileRect& a, const MapFileRect& b, MapFileRect& merged) {
+    if (a.y == b.y && a.h == b.h && a.x <= b.x + b.w && b.x <= a.x + a.w) {
+        merged = {std::min(a.x, b.x), a.y, std::max(a.x + a.w, b.x + b.w) - std::min(a.x, b.x), a.h};
+        return true;
+    }
+    if (a.x == b.x && a.w == b.w && a.y <= b.y + b.h && b.y <= a.y + a.h) {
+        merged = {a.x, std::min(a.y, b.y), a.w, std::max(a.y + a.h, b.y + b.h) - std::min(a.y, b.y)};
+        return true;
+    }
+    return false;
+}
+
+// Drop rects covered by another rect of the same category, then merge until nothing changes
+static void mergeRects(std::vector<MapFileRect>& rects) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < rects.size() && !changed; ++i) {
+            for (size_t j = 0; j < rects.size() && !changed; ++j) {
+                if (i == j) continue;
+                MapFileRect merged;
+                if (contains(rects[i], rects[j])) {
+                    rects.erase(rects.begin() + j);
+                    changed = true;
+                } else if (tryMerge(rects[i], rects[j], merged)) {
+                    rects[i] = merged;
+                    rects.erase(rects.begin() + j);
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+static bool writeCompiled(const std::string& path, const SourceMap& map) {
+    MapFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAP_FILE_MAGIC, sizeof(MAP_FILE_MAGIC));
+    header.version = MAP_FILE_VERSION;
+    header.width = map.width;
+    header.height = map.height;
+
+    std::string strings;
+    uint32_t offset = sizeof(MapFileHeader);
+    for (uint32_t i = 0; i < MAP_FILE_CATEGORY_COUNT; ++i) {
+        header.categories[i].rectOffset = offset;
+        header.categories[i].rectCount = static_cast<uint32_t>(map.rects[i].size());
+        offset += header.categories[i].rectCount * sizeof(MapFileRect);
+        header.categories[i].textureName = MAP_FILE_NO_STRING;
+        if (!map.textures[i].empty()) {
+            header.categories[i].textureName = static_cast<uint32_t>(strings.size());
+            strings += map.textures[i];
+            strings.push_back('\0');
+        }
+    }
+    header.stringTableOffset = offset;
+    header.stringTableSize = static_cast<uint32_t>(strings.size());
+
+    FILE* out = std::fopen(path.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Cannot write " << path << std::endl;
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1;
+    for (uint32_t i = 0; i < MAP_FILE_CATEGORY_COUNT && ok; ++i) {
+        if (!map.rects[i].empty()) ok = std::fwrite(map.rects[i].data(), sizeof(MapFileRect), map.rects[i].size(), out) == map.rects[i].size();
+    }
+    if (ok && !strings.empty()) ok = std::fwrite(strings.data(), 1, strings.size(), out) == strings.size();
+    ok = (std::fclose(out) == 0) && ok;
+    if (!ok) std::cerr << "Failed writing " << path << std::endl;
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <source.txt> <output.pim>" << std::endl;
+        return 1;
+    }
+    SourceMap map;
+    if (!parseSource(argv[1], map)) return 1;
+    for (uint32_t i = 0; i < MAP_FILE_CATEGORY_COUNT; ++i) {
+        size_t before = map.rects[i].size();
+        mergeRects(map.rects[i]);
+        if (before) std::cout << MAP_CATEGORY_NAMES[i] << ": " << before << " -> " << map.rects[i].size() << " rects\n";
+    }
+    if (!writeCompiled(argv[2], map)) return 1;
+    std::cout << "Wrote " << argv[2] << " (" << map.width << "x" << map.height << ")\n";
+    return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef MAP_FORMAT_H
+#define MAP_FORMAT_H
+
+// On-disk layout of compiled maps (.pim), shared by the game loader and the offline map compiler.
+// All fields are little-endian and 4-byte aligned so the file can be used straight from mmap.
+//
+//   MapFileHeader
+//   rect tables    one per category, MapFileRect[rectCount] at rectOffset
+//   string table   NUL-terminated texture paths, referenced by byte offset
+
+#include <cstdint>
+
+const char MAP_FILE_MAGIC[4] = {'P', 'I', 'M', 'P'};
+const uint32_t MAP_FILE_VERSION = 1;
+const uint32_t MAP_FILE_CATEGORY_COUNT = 8;  // Must match CATEGORY_COUNT in common.h
+const uint32_t MAP_FILE_NO_STRING = 0xFFFFFFFFu;
+
+// Keywords used by the map source files, in StructureCategory order
+const char* const MAP_CATEGORY_NAMES[MAP_FILE_CATEGORY_COUNT] = {
+    "barracks", "obstacle", "sand_pit", "rifle_range", "parade_deck", "chow_hall", "road", "water"
+};
+
+struct MapFileRect {
+    int32_t x, y, w, h;  // Same layout as SDL_Rect
+};
+
+struct MapFileCategory {
+    uint32_t rectOffset;   // Byte offset of the first MapFileRect
+    uint32_t rectCount;
+    uint32_t textureName;  // Offset into the string table, or MAP_FILE_NO_STRING
+    uint32_t reserved;
+};
+
+struct MapFileHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t width, height;  // Map size in pixels
+    uint32_t stringTableOffset;
+    uint32_t stringTableSize;
+    MapFileCategory categories[MAP_FILE_CATEGORY_COUNT];
+};
+
+#endif // MAP_FORMAT_H
@@ -0,0 +1,32 @@
+#include "message_queue.h"
+#include "text_renderer.h"
+#include <algorithm>
+
+void MessageQueue::push(const std::string& text, MessagePriority priority, Uint32 durationMs, Uint32 now, SDL_Color color) {
+    // The same message again (repeated escape attempts) just stays up longer
+    auto same = std::find_if(toasts.begin(), toasts.end(), [&](const Toast& toast) { return toast.text == text; });
+    if (same != toasts.end()) toasts.erase(same);
+    if (static_cast<int>(toasts.size()) >= MAX_VISIBLE_MESSAGES) {
+        if (toasts.back().priority > priority) return;  // Everything showing is more important
+        toasts.pop_back();
+    }
+    Toast toast = {text, color, priority, now, now + durationMs};
+    auto position = std::find_if(toasts.begin(), toasts.end(), [&](const Toast& other) { return other.priority <= priority; });
+    toasts.insert(position, toast);
+}
+
+void MessageQueue::update(Uint32 now) {
+    toasts.erase(std::remove_if(toasts.begin(), toasts.end(), [now](const Toast& toast) { return SDL_TICKS_PASSED(now, toast.expiresAt); }),
+                 toasts.end());
+}
+
+// Centered and stacked downward from the middle of the screen, where the blocking messages used to be
+void MessageQueue::draw(TextRenderer& text) const {
+    int y = HEIGHT / 2;
+    for (const auto& toast : toasts) {
+        int textW, textH;
+        text.measureText(toast.text, &textW, &textH);
+        text.drawText(toast.text, toast.color, (WIDTH - textW) / 2, y);
+        y += textH + 4;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef MESSAGE_QUEUE_H
+#define MESSAGE_QUEUE_H
+
+#include "common.h"
+#include <string>
+#include <vector>
+
+class TextRenderer;
+
+const int MAX_VISIBLE_MESSAGES = 3;
+const Uint32 MESSAGE_DURATION_MS = 1000;  // How long escape feedback stays up
+
+enum MessagePriority {
+    MESSAGE_LOW,
+    MESSAGE_NORMAL,
+    MESSAGE_HIGH
+};
+
+struct Toast {
+    std::string text;
+    SDL_Color color;
+    MessagePriority priority;
+    Uint32 shownAt, expiresAt;  // SDL_GetTicks() milliseconds
+};
+
+// Timed on-screen notifications drawn as part of the normal frame, so feedback never stalls the loop.
+// At most MAX_VISIBLE_MESSAGES are shown, highest priority first; a new message pushes out the
+// lowest-priority (then oldest) one, or is dropped if everything showing outranks it.
+class MessageQueue {
+private:
+    std::vector<Toast> toasts;  // Sorted by priority, then newest first
+
+public:
+    void push(const std::string& text, MessagePriority priority, Uint32 durationMs, Uint32 now, SDL_Color color = WHITE);
+    void update(Uint32 now);  // Drop expired messages
+    void draw(TextRenderer& text) const;
+    void clear() { toasts.clear(); }
+    bool empty() const { return toasts.empty(); }
+};
+
+#endif // MESSAGE_QUEUE_H
@@ -1,603 +1,580 @@
 // parris_island_trials.cpp
 #include "common.h"
 #include "rendering.h"
+#include "text_renderer.h"
+#include "world_map.h"
+#include "sim_core.h"
+#include "rng.h"
+#include "texture_atlas.h"
+#include "frame_clock.h"
+#include "profiler.h"
+#include "asset_loader.h"
+#include "message_queue.h"
+#include "input_replay.h"
+#include "job_system.h"
+#include "audio_scheduler.h"
+#include "resolution_scaler.h"
 #include <iostream>
 #include <string>
-#include <random>  // For random escape chance
+#include <random>  // For a fresh seed when none is given
+#include <cmath>
+#include <algorithm>
+
+// Command-line settings
+struct GameOptions {
+    int drillInstructorCount = 1;  // --dis N
+    int recruitCount = 1;          // --recruits N, platoon size (all follow the same controls)
+    int objectiveCount = 1;        // --objectives N, pieces of gear to collect
+    int dustPerFrame = 0;          // --dust N, particles blown in per storm frame (0 = light dust)
+    FramePacing pacing = PACING_VSYNC;  // --uncapped, --fps N
+    int targetFps = SIM_TICK_RATE;
+    Uint64 seed = 0;               // --seed N, 0 picks a random one
+    bool seedGiven = false;
+    int headlessTicks = 0;         // --headless N, simulate N ticks without a window and exit
+    std::string recordPath;        // --record FILE, save every tick's input for replaying
+    std::string replayPath;        // --replay FILE, play a recorded session back and verify its end state
+    double replaySpeed = 0.0;      // --speed X, show the replay in a window at X times real time (0 = headless)
+    bool dirtyRects = false;       // --dirty-rects, software rendering that repaints and presents only what changed
+    bool softwareBlit = false;     // --blitter, compose the world on the CPU with the SIMD blitter
+    float frameBudgetMs = 0.0f;    // --frame-budget MS, scale the world's resolution to hold it (0 = always native)
+};
 
 class ParrisIslandTrials {
 private:
+    GameOptions options;
     SDL_Window* window;
     SDL_Renderer* renderer;
     Renderer* gameRenderer;
     TTF_Font* font;
+    TextRenderer* textRenderer = nullptr;
+    TTF_Font* overlayFont = nullptr;
+    TextRenderer* overlayText = nullptr;  // Small print for the profiler overlay
     Mix_Music* bgMusic = nullptr;
     Mix_Chunk* diYell = nullptr, *footsteps = nullptr;
-    SDL_Texture* recruitTextures[4];
-    SDL_Texture* diTextures[2];
-    SDL_Texture* gearTexture;
-    SDL_Texture* barrackTexture;      // Texture for barracks
-    SDL_Texture* roadTexture;        // Texture for roads
-    SDL_Texture* obstacleTexture;    // Texture for obstacles
-    SDL_Texture* sandPitTexture;     // Texture for sand pits
-    SDL_Texture* rifleRangeTexture;  // Texture for rifle ranges
-    SDL_Texture* paradeDeckTexture;  // Texture for parade decks
-    SDL_Texture* chowHallTexture;    // Texture for chow halls
-    SDL_Texture* waterTexture;       // Texture for water areas
-    Vector2 recruitPos, diPos, gearPos;
-    std::vector<SDL_Rect> barracks, obstacleCourses, sandPits, roads, rifleRanges, paradeDecks, chowHalls;
-    float recruitSpeed = 1.5f, sprintSpeed = 3.0f, diSpeed = 1.5f;  // Match recruitSpeed and diSpeed, increase sprintSpeed slightly
-    float stamina = 100.0f, maxStamina = 100.0f, staminaDrain = 0.1f, staminaRegen = 0.2f;
-    int recruitFrame = 0, diFrame = 0, catchCount = 0, maxCatches = 15, catchCooldown = 120, lastCatchCheck = 0;
-    bool gearCollected = false, running = true, diLatched = false;
-    int frameCount = 0, weatherTimer = 0, latchTimer = 0;
-    const int LATCH_DURATION = 120;  // Frames to stay latched before automatic escape (2 seconds at 60 FPS)
-
-    SDL_Texture* renderText(const std::string& text, SDL_Color color) {
-        SDL_Surface* surface = TTF_RenderText_Solid(font, text.c_str(), color);
-        if (!surface) {
-            std::cerr << "Failed to render text: " << TTF_GetError() << std::endl;
-            return nullptr;
-        }
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-        SDL_FreeSurface(surface);
-        return texture;
-    }
-
-    Vector2 slideAroundObstacle(Vector2 pos, Vector2 direction, float speed, const SDL_Rect& obstacle) {
-        SDL_Rect newRect = {static_cast<int>(pos.x), static_cast<int>(pos.y), SPRITE_SIZE, SPRITE_SIZE};
-        if (SDL_HasIntersection(&newRect, &obstacle)) {
-            Vector2 slidePos(pos.x + direction.x * speed * 2, pos.y);
-            newRect = {static_cast<int>(slidePos.x), static_cast<int>(slidePos.y), SPRITE_SIZE, SPRITE_SIZE};
-            if (!SDL_HasIntersection(&newRect, &obstacle)) return slidePos;
-            slidePos = Vector2(pos.x, pos.y + direction.y * speed * 2);
-            newRect = {static_cast<int>(slidePos.x), static_cast<int>(slidePos.y), SPRITE_SIZE, SPRITE_SIZE};
-            if (!SDL_HasIntersection(&newRect, &obstacle)) return slidePos;
-            return pos;  // Stay in place if still stuck
+    AudioScheduler audio;  // Cooldowns and voice limits for the sound effects
+    ResolutionScaler resolutionScaler;  // World render scale for --frame-budget
+    TextureAtlas* spriteAtlas = nullptr;  // Every sprite and structure texture, packed at startup
+    WorldMap world;  // Compiled map, shared read-only with the Renderer and the simulation
+    SimCore sim;     // Game rules and state; this class only adds input, audio and drawing
+    Rng effectsRng;  // Cosmetic randomness (dust) kept out of the simulation's sequence
+    SimInput pendingInput;  // Escape presses collected by handleEvents() for the next tick
+    InputReplay replay;     // Session being recorded (--record) or played back (--replay)
+    int exitStatus = 0;
+    MessageQueue messages;  // Escape feedback, drawn with the frame instead of stalling it
+    FrameClock frameClock;  // Fixed simulation ticks, independent of the render rate
+    Profiler profiler;      // Per-phase frame timings: F3 shows the overlay, F4 writes a trace
+    JobSystem jobs;         // Worker threads for DI movement, dust and HUD text
+    std::vector<float> previousRecruitX, previousRecruitY;  // State before the last tick, for interpolated rendering
+    std::vector<float> previousDiX, previousDiY;
+    std::vector<float> drawRecruitX, drawRecruitY, drawDiX, drawDiY;  // Interpolated positions handed to the Renderer
+    std::vector<float> drawGearX, drawGearY;  // Objectives still to collect
+    bool running = true;
+
+    // Progress bar shown while the loader's workers decode assets
+    void drawLoadingScreen(float progress) {
+        SDL_Rect frame = {WIDTH / 4, HEIGHT / 2, WIDTH / 2, 20};
+        SDL_Rect bar = {frame.x, frame.y, static_cast<int>(frame.w * progress), frame.h};
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+        SDL_RenderDrawRect(renderer, &frame);
+        SDL_RenderFillRect(renderer, &bar);
+        textRenderer->drawText("Loading...", WHITE, frame.x, frame.y - 50);
+        textRenderer->flush();
+        if (options.dirtyRects) {
+            SDL_RenderFlush(renderer);
+            SDL_UpdateWindowSurface(window);
+        } else {
+            SDL_RenderPresent(renderer);
         }
-        return Vector2(pos.x + direction.x * speed, pos.y + direction.y * speed);
     }
 
-    // Helper to generate random number (0 to 1) for escape chance
-    float getRandomChance() {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(0.0, 1.0);
-        return dis(gen);
+    // Camera centered on pos, scrolled no further than the map edges
+    Vector2 cameraFor(Vector2 pos) const {
+        Vector2 cameraPos(pos.x - WIDTH / 2, pos.y - HEIGHT / 2);
+        cameraPos.x = std::max(0.0f, std::min(cameraPos.x, static_cast<float>(world.width() - WIDTH)));
+        cameraPos.y = std::max(0.0f, std::min(cameraPos.y, static_cast<float>(world.height() - HEIGHT)));
+        return cameraPos;
     }
 
 public:
-    ParrisIslandTrials() {
+    explicit ParrisIslandTrials(const GameOptions& gameOptions) : options(gameOptions) {
         if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0 || TTF_Init() < 0 || Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
             std::cerr << "Initialization failed: " << SDL_GetError() << " " << TTF_GetError() << " " << Mix_GetError() << std::endl;
             running = false;
+        } else {
+            audio.init();
         }
         window = SDL_CreateWindow("The Parris Island Trials", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WIDTH, HEIGHT, SDL_WINDOW_SHOWN);
-        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+        if (options.dirtyRects) {
+            // Draw straight into the window surface, so changed areas can be copied to the screen on their own
+            SDL_Surface* surface = window ? SDL_GetWindowSurface(window) : nullptr;
+            renderer = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+        } else {
+            Uint32 rendererFlags = SDL_RENDERER_ACCELERATED | (options.pacing == PACING_VSYNC ? SDL_RENDERER_PRESENTVSYNC : 0);
+            renderer = SDL_CreateRenderer(window, -1, rendererFlags);
+        }
         if (!window || !renderer) {
             std::cerr << "Window/Renderer failed: " << SDL_GetError() << std::endl;
             running = false;
         }
+        frameClock.setPacing(options.pacing, options.targetFps);
+        SDL_RendererInfo rendererInfo;
+        if (renderer && options.pacing == PACING_VSYNC &&
+            (SDL_GetRendererInfo(renderer, &rendererInfo) < 0 || !(rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC))) {
+            frameClock.setPacing(PACING_TARGET, options.targetFps);  // No vsync available, pace ourselves
+        }
         font = TTF_OpenFont("sprites/DejaVuSans.ttf", 36);
         if (!font) std::cerr << "Font failed: " << TTF_GetError() << std::endl;
+        overlayFont = TTF_OpenFont("sprites/DejaVuSans.ttf", 14);
+        if (renderer) textRenderer = new TextRenderer(renderer, font);
+        if (renderer && overlayFont) overlayText = new TextRenderer(renderer, overlayFont);
 
-        bgMusic = Mix_LoadMUS("sprites/march_music.mp3");
-        diYell = Mix_LoadWAV("sprites/di_yell.wav");
-        footsteps = Mix_LoadWAV("sprites/footsteps.wav");
-        if (bgMusic) Mix_PlayMusic(bgMusic, -1);
-
-        // Load and verify recruit sprites
-        for (int i = 0; i < 4; ++i) {
-            std::string path = "sprites/recruit_walk" + std::to_string(i + 1) + ".png";
-            SDL_Surface* surface = IMG_Load(path.c_str());
-            if (!surface) {
-                std::cerr << "Recruit sprite failed: " << path << " " << IMG_GetError() << std::endl;
-                running = false;
-                break;
-            }
-            recruitTextures[i] = SDL_CreateTextureFromSurface(renderer, surface);
-            SDL_FreeSurface(surface);
-            if (!recruitTextures[i]) {
-                std::cerr << "Failed to create recruit texture from " << path << ": " << SDL_GetError() << std::endl;
-                running = false;
-                break;
-            }
-        }
-
-        // Load and verify DI sprites
-        for (int i = 0; i < 2; ++i) {
-            std::string path = "sprites/di_yell" + std::to_string(i + 1) + ".png";
-            SDL_Surface* surface = IMG_Load(path.c_str());
-            if (!surface) {
-                std::cerr << "DI sprite failed: " << path << " " << IMG_GetError() << std::endl;
-                running = false;
-                break;
-            }
-            diTextures[i] = SDL_CreateTextureFromSurface(renderer, surface);
-            SDL_FreeSurface(surface);
-            if (!diTextures[i]) {
-                std::cerr << "Failed to create DI texture from " << path << ": " << SDL_GetError() << std::endl;
-                running = false;
-                break;
-            }
-        }
-
-        // Load and verify gear sprite
-        SDL_Surface* gearSurface = IMG_Load("sprites/gear.png");
-        if (!gearSurface) {
-            std::cerr << "Gear sprite failed: " << IMG_GetError() << std::endl;
+        // Load the compiled map first, it names the structure textures
+        if (!world.load("maps/parris_island.pim")) {
             running = false;
-        } else {
-            gearTexture = SDL_CreateTextureFromSurface(renderer, gearSurface);
-            SDL_FreeSurface(gearSurface);
-            if (!gearTexture) {
-                std::cerr << "Failed to create gear texture: " << SDL_GetError() << std::endl;
-                running = false;
-            }
         }
 
-        // Load and verify map textures with detailed error messages
-        barrackTexture = IMG_LoadTexture(renderer, "sprites/barrack.png");
-        if (!barrackTexture) {
-            std::cerr << "Barrack texture failed: " << IMG_GetError() << " (Path: sprites/barrack.png)" << std::endl;
-            running = false;
+        // Pack every sprite and structure texture into the atlas (reused from disk while the images are unchanged)
+        spriteAtlas = new TextureAtlas();
+        for (int i = 0; i < RECRUIT_FRAMES; ++i) {
+            spriteAtlas->addImage("recruit_walk" + std::to_string(i + 1), "sprites/recruit_walk" + std::to_string(i + 1) + ".png");
         }
-        roadTexture = IMG_LoadTexture(renderer, "sprites/road.png");
-        if (!roadTexture) {
-            std::cerr << "Road texture failed: " << IMG_GetError() << " (Path: sprites/road.png)" << std::endl;
-            running = false;
+        for (int i = 0; i < DI_FRAMES; ++i) {
+            spriteAtlas->addImage("di_yell" + std::to_string(i + 1), "sprites/di_yell" + std::to_string(i + 1) + ".png");
         }
-        obstacleTexture = IMG_LoadTexture(renderer, "sprites/obstacle.png");
-        if (!obstacleTexture) {
-            std::cerr << "Obstacle texture failed: " << IMG_GetError() << " (Path: sprites/obstacle.png)" << std::endl;
-            running = false;
-        }
-        sandPitTexture = IMG_LoadTexture(renderer, "sprites/sand_pit.png");
-        if (!sandPitTexture) {
-            std::cerr << "Sand pit texture failed: " << IMG_GetError() << " (Path: sprites/sand_pit.png)" << std::endl;
-            running = false;
-        }
-        rifleRangeTexture = IMG_LoadTexture(renderer, "sprites/rifle_range.png");
-        if (!rifleRangeTexture) {
-            std::cerr << "Rifle range texture failed: " << IMG_GetError() << " (Path: sprites/rifle_range.png)" << std::endl;
-            running = false;
-        }
-        paradeDeckTexture = IMG_LoadTexture(renderer, "sprites/parade_deck.png");
-        if (!paradeDeckTexture) {
-            std::cerr << "Parade deck texture failed: " << IMG_GetError() << " (Path: sprites/parade_deck.png)" << std::endl;
-            running = false;
-        }
-        chowHallTexture = IMG_LoadTexture(renderer, "sprites/chow_hall.png");
-        if (!chowHallTexture) {
-            std::cerr << "Chow hall texture failed: " << IMG_GetError() << " (Path: sprites/chow_hall.png)" << std::endl;
-            running = false;
-        }
-        waterTexture = IMG_LoadTexture(renderer, "sprites/water.png");
-        if (!waterTexture) {
-            std::cerr << "Water texture failed: " << IMG_GetError() << " (Path: sprites/water.png)" << std::endl;
-            running = false;
+        spriteAtlas->addImage("gear", "sprites/gear.png");
+        for (int i = 0; i < CATEGORY_COUNT && world.isLoaded(); ++i) {
+            const char* path = world.textureName(static_cast<StructureCategory>(i));
+            if (path) spriteAtlas->addImage(MAP_CATEGORY_NAMES[i], path);  // Without one the category is drawn with a flat color
         }
 
-        if (!running) {
+        // Decode images and audio on worker threads behind a progress screen; only the texture upload
+        // below has to happen on this thread
+        IMG_Init(IMG_INIT_PNG);  // Initialize the decoders here, lazy initialization from several workers would race
+        Mix_Init(MIX_INIT_MP3);
+        bool assetsFailed = false;  // Rather than the window being closed during loading
+        if (running) {
+            AssetLoader loader;
+            loader.add([this, &loader] { return spriteAtlas->build("sprites/atlas_cache", &loader); });
+            loader.add([this] { bgMusic = Mix_LoadMUS("sprites/march_music.mp3"); return true; });  // Audio is optional
+            loader.add([this] { diYell = Mix_LoadWAV("sprites/di_yell.wav"); return true; });
+            loader.add([this] { footsteps = Mix_LoadWAV("sprites/footsteps.wav"); return true; });
+            while (running && !loader.waitFor(10)) {
+                SDL_Event event;
+                while (SDL_PollEvent(&event)) {
+                    if (event.type == SDL_QUIT) running = false;  // Closing the window abandons the remaining jobs
+                }
+                drawLoadingScreen(loader.progress());
+            }
+            assetsFailed = running && !loader.succeeded();
+        }
+        if (running && !assetsFailed && !spriteAtlas->upload(renderer)) assetsFailed = true;
+        if (assetsFailed) {
             std::cerr << "Critical asset loading failed, exiting initialization." << std::endl;
-            return;
+            running = false;
         }
+        if (!running) return;
 
-        recruitPos = Vector2(400, 250);  // Start near west road, on ground
-        diPos = Vector2(1200, 500);      // Start near east road, on ground
-        gearPos = Vector2(random() % (MAP_WIDTH - 200) + 100, random() % (MAP_HEIGHT - 200) + 100);
+        audio.setSound(SOUND_DI_YELL, diYell);
+        audio.setSound(SOUND_FOOTSTEP, footsteps);
+        audio.playMusic(bgMusic);
 
-        // Initialize map (roads, buildings, etc., passed to Renderer)
-        const int TILE_SIZE = 32;
-        std::vector<SDL_Rect> tiles, buildings, obstacles, pits, roadTiles, ranges, decks, chows;
-        for (int y = 0; y < MAP_HEIGHT; y += TILE_SIZE) {
-            for (int x = 0; x < MAP_WIDTH; x += TILE_SIZE) {
-                tiles.push_back({x, y, TILE_SIZE, TILE_SIZE});
+        Uint64 seed = options.seedGiven ? options.seed : (static_cast<Uint64>(std::random_device()()) << 32) | std::random_device()();
+        int drillInstructorCount = options.drillInstructorCount;
+        int recruitCount = options.recruitCount, objectiveCount = options.objectiveCount;
+        if (!options.replayPath.empty()) {
+            if (!replay.load(options.replayPath)) {
+                running = false;
+                exitStatus = 1;
+                return;
             }
+            seed = replay.seed();
+            drillInstructorCount = replay.drillInstructorCount();
+            recruitCount = replay.recruitCount();
+            objectiveCount = replay.objectiveCount();
+            frameClock.setTimeScale(options.replaySpeed);
+        } else if (!options.recordPath.empty()) {
+            replay.start(seed, drillInstructorCount, recruitCount, objectiveCount);
         }
-        roadTiles.push_back({800 - 16, 0, 32, MAP_HEIGHT});         // Main north-south road
-        roadTiles.push_back({800 - 16, 300 - 16, 32, 32});          // Upper crossroad
-        roadTiles.push_back({800 - 16, 900 - 16, 32, 32});          // Lower crossroad
-        roadTiles.push_back({100, 300 - 16, 16, 32});               // Side path to obstacle
-        roadTiles.push_back({1500, 300 - 16, 16, 32});              // Side path to rifle range
-        roadTiles.push_back({100, 900 - 16, 16, 32});               // Side path to parade deck
-        roadTiles.push_back({1500, 900 - 16, 16, 32});              // Side path to chow hall
-        buildings.push_back({200, 100, 64, 64});    // Barracks 1
-        buildings.push_back({500, 400, 64, 64});    // Barracks 2
-        buildings.push_back({600, 500, 64, 64});    // Chow Hall
-        obstacles.push_back({100, 300, 192, 48});   // Obstacle Course
-        pits.push_back({300, 300, 100, 100});       // Sand Pit
-        ranges.push_back({600, 100, 192, 48});      // Rifle Range
-        decks.push_back({100, 500, 192, 48});       // Parade Deck
-        chows.push_back({600, 500, 64, 64});        // Chow Hall (already in buildings, but included for consistency)
-
-        barracks = buildings;
-        obstacleCourses = obstacles;
-        sandPits = pits;
-        roads = roadTiles;
-        rifleRanges = ranges;
-        paradeDecks = decks;
-        chowHalls = chows;
+        std::cout << "Simulation seed: " << seed << "\n";
+        sim.init(&world, drillInstructorCount, seed, recruitCount, objectiveCount);
+        sim.setProfiler(&profiler);
+        sim.setJobSystem(&jobs);
+        effectsRng = Rng(seed, 7);
 
         gameRenderer = new Renderer(window, renderer);
-        gameRenderer->initializeMap(tiles, buildings, obstacles, pits, roadTiles, ranges, decks, chows, std::vector<SDL_Rect>()); // No water areas for now
-        gameRenderer->setTextures(recruitTextures[0], diTextures[0], gearTexture,
-                                 barrackTexture, roadTexture, obstacleTexture,
-                                 sandPitTexture, rifleRangeTexture, paradeDeckTexture,
-                                 chowHallTexture, waterTexture);
+        gameRenderer->initializeMap(&world);
+        gameRenderer->setJobSystem(&jobs);
+        gameRenderer->setSprites(*spriteAtlas);
+        if (options.dirtyRects) gameRenderer->setDirtyRects(true);
+        if (options.softwareBlit) gameRenderer->setSoftwareBlit(true);
+        if (options.frameBudgetMs > 0 && !gameRenderer->setDynamicResolution(true)) options.frameBudgetMs = 0;
+        resolutionScaler.setBudget(options.frameBudgetMs);
     }
 
     ~ParrisIslandTrials() {
         if (gameRenderer) delete gameRenderer;
+        if (textRenderer) delete textRenderer;
+        if (overlayText) delete overlayText;
         if (font) TTF_CloseFont(font);
+        if (overlayFont) TTF_CloseFont(overlayFont);
+        audio.stopAll();
         if (bgMusic) Mix_FreeMusic(bgMusic);
         if (diYell) Mix_FreeChunk(diYell);
         if (footsteps) Mix_FreeChunk(footsteps);
-        if (barrackTexture) SDL_DestroyTexture(barrackTexture);
-        if (roadTexture) SDL_DestroyTexture(roadTexture);
-        if (obstacleTexture) SDL_DestroyTexture(obstacleTexture);
-        if (sandPitTexture) SDL_DestroyTexture(sandPitTexture);
-        if (rifleRangeTexture) SDL_DestroyTexture(rifleRangeTexture);
-        if (paradeDeckTexture) SDL_DestroyTexture(paradeDeckTexture);
-        if (chowHallTexture) SDL_DestroyTexture(chowHallTexture);
-        if (waterTexture) SDL_DestroyTexture(waterTexture);
+        if (spriteAtlas) delete spriteAtlas;
         Mix_CloseAudio();
+        Mix_Quit();
+        IMG_Quit();
         TTF_Quit();
-        for (int i = 0; i < 4; ++i) SDL_DestroyTexture(recruitTextures[i]);
-        for (int i = 0; i < 2; ++i) SDL_DestroyTexture(diTextures[i]);
-        SDL_DestroyTexture(gearTexture);
         SDL_DestroyRenderer(renderer);
         SDL_DestroyWindow(window);
         SDL_Quit();
     }
 
     bool isRunning() const { return running; }
+    int getExitStatus() const { return exitStatus; }
 
-    void run() {
+private:
+    void handleEvents() {
+        ProfileScope scope(&profiler, PHASE_EVENTS);
         SDL_Event event;
-        while (running) {
-            while (SDL_PollEvent(&event)) {
-                if (event.type == SDL_QUIT) running = false;
-                else if (event.type == SDL_KEYDOWN) {
-                    if (event.key.keysym.sym == SDLK_ESCAPE) running = false;
-                    else if (diLatched && event.key.keysym.sym == SDLK_SPACE) {  // Attempt to escape when latched
-                        float escapeChance = std::min(0.9f, stamina / maxStamina);  // Cap at 90% chance, even at full stamina
-                        if (getRandomChance() < escapeChance) {
-                            diLatched = false;
-                            latchTimer = 0;
-                            diPos = Vector2(diPos.x + random() % 200 - 100, diPos.y + random() % 200 - 100);  // DI backs off further
-                            std::cout << "Escaped the DI's grasp!\n";
-                            // Visual feedback (on-screen message)
-                            SDL_Texture* escapeText = renderText("Escaped the DI!", WHITE);
-                            if (escapeText) {
-                                int textW, textH;
-                                SDL_QueryTexture(escapeText, NULL, NULL, &textW, &textH);
-                                SDL_Rect textRect = {(WIDTH - textW) / 2, HEIGHT / 2, textW, textH};
-                                SDL_RenderCopy(renderer, escapeText, NULL, &textRect);
-                                SDL_DestroyTexture(escapeText);
-                                SDL_RenderPresent(renderer);
-                                SDL_Delay(1000);  // Show message for 1 second
-                            }
-                        } else {
-                            stamina -= 15.0f;  // Increase stamina cost for failed escape
-                            std::cout << "Failed to escape the DI! Stamina reduced.\n";
-                            // Visual feedback for failed escape
-                            SDL_Texture* failText = renderText("Failed to Escape!", WHITE);
-                            if (failText) {
-                                int textW, textH;
-                                SDL_QueryTexture(failText, NULL, NULL, &textW, &textH);
-                                SDL_Rect textRect = {(WIDTH - textW) / 2, HEIGHT / 2, textW, textH};
-                                SDL_RenderCopy(renderer, failText, NULL, &textRect);
-                                SDL_DestroyTexture(failText);
-                                SDL_RenderPresent(renderer);
-                                SDL_Delay(1000);  // Show message for 1 second
-                            }
-                        }
-                    }
-                }
-            }
-
-            const Uint8* keys = SDL_GetKeyboardState(NULL);
-            Vector2 direction(0, 0);
-            bool isSprinting = keys[SDL_SCANCODE_LSHIFT] || keys[SDL_SCANCODE_RSHIFT];
-            if (keys[SDL_SCANCODE_W]) direction.y -= 1;
-            if (keys[SDL_SCANCODE_S]) direction.y += 1;
-            if (keys[SDL_SCANCODE_A]) direction.x -= 1;
-            if (keys[SDL_SCANCODE_D]) direction.x += 1;
-
-            if (direction.x != 0 || direction.y != 0) {
-                float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
-                if (length != 0) { direction.x /= length; direction.y /= length; }
-            }
-
-            float currentSpeed = (isSprinting && stamina > 0 && !diLatched) ? sprintSpeed : recruitSpeed;
-            if (isSprinting && stamina > 0 && !diLatched) stamina -= staminaDrain;
-            else if (stamina < maxStamina && !diLatched) stamina += staminaRegen;
-            stamina = std::max(0.0f, std::min(stamina, maxStamina));
-
-            // Move recruit, check collisions with all structures, unless latched
-            Vector2 newPos = recruitPos;
-            bool inSandPit = false;
-
-            if (!diLatched) {
-                // Slide around or slow down in sand pits for all structures except roads
-                newPos = slideAroundObstacle(newPos, direction, currentSpeed, barracks[0]);
-                for (const auto& barrack : barracks) {
-                    newPos = slideAroundObstacle(newPos, direction, currentSpeed, barrack);
-                    SDL_Rect recruitRect = {static_cast<int>(newPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
-                    if (SDL_HasIntersection(&recruitRect, &barrack)) newPos = recruitPos;  // Block movement into barracks
-                }
-                for (const auto& obstacle : obstacleCourses) {
-                    newPos = slideAroundObstacle(newPos, direction, currentSpeed, obstacle);
-                    SDL_Rect recruitRect = {static_cast<int>(newPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
-                    if (SDL_HasIntersection(&recruitRect, &obstacle)) newPos = recruitPos;  // Block movement into obstacles
-                }
-                for (const auto& pit : sandPits) {
-                    SDL_Rect recruitRect = {static_cast<int>(newPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
-                    if (SDL_HasIntersection(&recruitRect, &pit)) {
-                        inSandPit = true;  // Flag that we're in a sand pit
-                        stamina -= staminaDrain;  // Drain stamina in sand pit
-                        // Apply slower speed (e.g., half the current speed or a fixed slow speed)
-                        float slowSpeed = currentSpeed / 2.0f;  // Halve the speed in sand pits
-                        newPos = Vector2(recruitPos.x + direction.x * slowSpeed, recruitPos.y + direction.y * slowSpeed);
-                    }
-                }
-                for (const auto& range : rifleRanges) {
-                    SDL_Rect recruitRect = {static_cast<int>(newPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
-                    if (SDL_HasIntersection(&recruitRect, &range)) newPos = recruitPos;  // Block movement into rifle range
-                }
-                for (const auto& deck : paradeDecks) {
-                    SDL_Rect recruitRect = {static_cast<int>(newPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
-                    if (SDL_HasIntersection(&recruitRect, &deck)) newPos = recruitPos;  // Block movement into parade deck
-                }
-                for (const auto& chow : chowHalls) {
-                    newPos = slideAroundObstacle(newPos, direction, currentSpeed, chow);
-                    SDL_Rect recruitRect = {static_cast<int>(newPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
-                    if (SDL_HasIntersection(&recruitRect, &chow)) newPos = recruitPos;  // Block movement into chow hall
-                }
-
-                // Apply movement if not blocked
-                recruitPos = newPos;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) running = false;
+            else if (event.type == SDL_KEYDOWN) {
+                if (event.key.keysym.sym == SDLK_ESCAPE) running = false;
+                else if (event.key.keysym.sym == SDLK_SPACE) pendingInput.escape = true;  // Attempt to escape when latched
+                else if (event.key.keysym.sym == SDLK_F3) profiler.toggleOverlay();
+                else if (event.key.keysym.sym == SDLK_F4) writeProfile();
             }
+        }
+    }
 
-            // Ensure recruit stays on ground (not above buildings), unless latched
-            if (!diLatched) {
-                for (const auto& barrack : barracks) {
-                    if (recruitPos.x >= barrack.x && recruitPos.x <= barrack.x + barrack.w &&
-                        recruitPos.y < barrack.y + barrack.h) {
-                        recruitPos.y = barrack.y + barrack.h;  // Push recruit to ground level below building
-                    }
-                }
-                for (const auto& chow : chowHalls) {
-                    if (recruitPos.x >= chow.x && recruitPos.x <= chow.x + chow.w &&
-                        recruitPos.y < chow.y + chow.h) {
-                        recruitPos.y = chow.y + chow.h;  // Push recruit to ground level below chow hall
-                    }
-                }
+    // One fixed simulation tick: sample the keyboard, step the rules, then play out what happened
+    void step() {
+        const Uint8* keys = SDL_GetKeyboardState(NULL);
+        SimInput input = pendingInput;
+        input.sprint = keys[SDL_SCANCODE_LSHIFT] || keys[SDL_SCANCODE_RSHIFT];
+        input.moveY = (keys[SDL_SCANCODE_S] ? 1 : 0) - (keys[SDL_SCANCODE_W] ? 1 : 0);
+        input.moveX = (keys[SDL_SCANCODE_D] ? 1 : 0) - (keys[SDL_SCANCODE_A] ? 1 : 0);
+        pendingInput = SimInput();
+        if (!options.replayPath.empty() && !replay.next(input)) {
+            running = false;  // Every recorded tick has been played
+            return;
+        }
+        if (!options.recordPath.empty() && options.replayPath.empty()) replay.record(input);
+
+        // Dust already in the air falls on a worker while the tick is simulated. Its view is the camera
+        // before the tick, at most a few pixels off, which only matters for culling.
+        JobCounter dustUpdated;
+        Vector2 viewPos = cameraFor(sim.state().recruits.position(0));
+        SDL_Rect view = {static_cast<int>(viewPos.x), static_cast<int>(viewPos.y), WIDTH, HEIGHT};
+        jobs.submit([this, view] {
+            ProfileScope scope(&profiler, PHASE_PARTICLES);
+            gameRenderer->getDustParticles().update(view, &jobs);  // The one particle update per tick
+        }, dustUpdated);
+        sim.step(input);
+
+        const SimState& state = sim.state();
+        for (const SimEvent& event : sim.events()) {
+            switch (event.type) {
+            case SIM_EVENT_ESCAPED:
+                std::cout << "Escaped the DI's grasp!\n";
+                messages.push("Escaped the DI!", MESSAGE_HIGH, MESSAGE_DURATION_MS, SDL_GetTicks());
+                break;
+            case SIM_EVENT_ESCAPE_FAILED:
+                std::cout << "Failed to escape the DI! Stamina reduced.\n";
+                messages.push("Failed to Escape!", MESSAGE_NORMAL, MESSAGE_DURATION_MS, SDL_GetTicks());
+                break;
+            case SIM_EVENT_AUTO_ESCAPED:
+                std::cout << "Escaped the DI's grasp automatically!\n";
+                messages.push("Automatically Escaped the DI!", MESSAGE_HIGH, MESSAGE_DURATION_MS, SDL_GetTicks());
+                break;
+            case SIM_EVENT_CAUGHT:
+                audio.play(SOUND_DI_YELL, SDL_GetTicks());
+                std::cout << "DI caught you! Times caught: " << event.value << "/" << MAX_CATCHES << "\n";
+                break;
+            case SIM_EVENT_GAME_OVER:
+                running = false;
+                std::cout << "DI won! You strip your blouse and head to the sand pit. Game Over!\n";
+                break;
+            case SIM_EVENT_OBJECTIVE_COLLECTED:
+                std::cout << "Gear secured, " << event.value << " more to go.\n";
+                messages.push("Gear Secured! " + std::to_string(event.value) + " to Go", MESSAGE_NORMAL, MESSAGE_DURATION_MS, SDL_GetTicks());
+                break;
+            case SIM_EVENT_GEAR_COLLECTED:
+                std::cout << "Gear collected! DI backs off... for now.\n";
+                break;
+            case SIM_EVENT_FOOTSTEP:
+                audio.play(SOUND_FOOTSTEP, SDL_GetTicks());
+                break;
             }
+        }
 
-            // Update camera (center on recruit, scroll if near edges)
-            Vector2 cameraPos = recruitPos;
-            cameraPos.x -= WIDTH / 2;
-            cameraPos.y -= HEIGHT / 2;
-            cameraPos.x = std::max(0.0f, std::min(cameraPos.x, static_cast<float>(MAP_WIDTH - WIDTH)));
-            cameraPos.y = std::max(0.0f, std::min(cameraPos.y, static_cast<float>(MAP_HEIGHT - HEIGHT)));
-
-            // Keep recruit on map
-            recruitPos.x = std::max(0.0f, std::min(recruitPos.x, static_cast<float>(MAP_WIDTH - SPRITE_SIZE)));
-            recruitPos.y = std::max(0.0f, std::min(recruitPos.y, static_cast<float>(MAP_HEIGHT - SPRITE_SIZE)));
-
-            // DI chasing logic (stops if gear collected, with obstacle avoidance and latching)
-            if (!gearCollected) {
-                if (diLatched) {
-                    // DI is latched onto recruit, no movement, increment latch timer
-                    latchTimer++;
-                    diPos = recruitPos;  // DI stays on recruit while latched
-                    if (latchTimer >= LATCH_DURATION || (stamina <= 0 && latchTimer >= LATCH_DURATION / 2)) {  // Automatic escape if timed out or low stamina
-                        diLatched = false;
-                        latchTimer = 0;
-                        diPos = Vector2(diPos.x + random() % 200 - 100, diPos.y + random() % 200 - 100);  // DI backs off further
-                        std::cout << "Escaped the DI's grasp automatically!\n";
-                        // Visual feedback for automatic escape
-                        SDL_Texture* autoEscapeText = renderText("Automatically Escaped the DI!", WHITE);
-                        if (autoEscapeText) {
-                            int textW, textH;
-                            SDL_QueryTexture(autoEscapeText, NULL, NULL, &textW, &textH);
-                            SDL_Rect textRect = {(WIDTH - textW) / 2, HEIGHT / 2, textW, textH};
-                            SDL_RenderCopy(renderer, autoEscapeText, NULL, &textRect);
-                            SDL_DestroyTexture(autoEscapeText);
-                            SDL_RenderPresent(renderer);
-                            SDL_Delay(1000);  // Show message for 1 second
-                        }
-                    }
-                } else {
-                    Vector2 diDirection(recruitPos.x - diPos.x, recruitPos.y - diPos.y);
-                    float length = std::sqrt(diDirection.x * diDirection.x + diDirection.y * diDirection.y);
-                    if (length != 0) { diDirection.x /= length; diDirection.y /= length; }
-                    Vector2 newDiPos = diPos;
-                    bool diInSandPit = false;
-
-                    newDiPos = slideAroundObstacle(newDiPos, diDirection, diSpeed, barracks[0]);
-                    for (const auto& barrack : barracks) {
-                        newDiPos = slideAroundObstacle(newDiPos, diDirection, diSpeed, barrack);
-                        SDL_Rect diRect = {static_cast<int>(newDiPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
-                        if (SDL_HasIntersection(&diRect, &barrack)) newDiPos = diPos;  // Block movement into barracks
-                    }
-                    for (const auto& obstacle : obstacleCourses) {
-                        newDiPos = slideAroundObstacle(newDiPos, diDirection, diSpeed, obstacle);
-                        SDL_Rect diRect = {static_cast<int>(newDiPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
-                        if (SDL_HasIntersection(&diRect, &obstacle)) newDiPos = diPos;  // Block movement into obstacles
-                    }
-                    for (const auto& pit : sandPits) {
-                        SDL_Rect diRect = {static_cast<int>(newDiPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
-                        if (SDL_HasIntersection(&diRect, &pit)) {
-                            diInSandPit = true;  // Flag that DI is in a sand pit
-                            // Apply slower speed (e.g., half the DI speed or a fixed slow speed)
-                            float diSlowSpeed = diSpeed / 2.0f;  // Halve the speed in sand pits
-                            newDiPos = Vector2(diPos.x + diDirection.x * diSlowSpeed, diPos.y + diDirection.y * diSlowSpeed);
-                        }
-                    }
-                    for (const auto& range : rifleRanges) {
-                        SDL_Rect diRect = {static_cast<int>(newDiPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
-                        if (SDL_HasIntersection(&diRect, &range)) newDiPos = diPos;  // DI avoids rifle range
-                    }
-                    for (const auto& deck : paradeDecks) {
-                        SDL_Rect diRect = {static_cast<int>(newDiPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
-                        if (SDL_HasIntersection(&diRect, &deck)) newDiPos = diPos;  // DI avoids parade deck
-                    }
-                    for (const auto& chow : chowHalls) {
-                        newDiPos = slideAroundObstacle(newDiPos, diDirection, diSpeed, chow);
-                        SDL_Rect diRect = {static_cast<int>(newDiPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
-                        if (SDL_HasIntersection(&diRect, &chow)) newDiPos = diPos;  // Block movement into chow hall
-                    }
-
-                    diPos = newDiPos;
-
-                    // Ensure DI stays on ground
-                    for (const auto& barrack : barracks) {
-                        if (diPos.x >= barrack.x && diPos.x <= barrack.x + barrack.w &&
-                            diPos.y < barrack.y + barrack.h) {
-                            diPos.y = barrack.y + barrack.h;  // Push DI to ground level below building
-                        }
-                    }
-                    for (const auto& chow : chowHalls) {
-                        if (diPos.x >= chow.x && diPos.x <= chow.x + chow.w &&
-                            diPos.y < chow.y + chow.h) {
-                            diPos.y = chow.y + chow.h;  // Push DI to ground level below chow hall
-                        }
-                    }
-
-                    // Keep DI on map
-                    diPos.x = std::max(0.0f, std::min(diPos.x, static_cast<float>(MAP_WIDTH - SPRITE_SIZE)));
-                    diPos.y = std::max(0.0f, std::min(diPos.y, static_cast<float>(MAP_HEIGHT - SPRITE_SIZE)));
-
-                    // Check for catching the recruit (only if not already latched)
-                    float distanceToDi = std::sqrt((recruitPos.x - diPos.x) * (recruitPos.x - diPos.x) +
-                                                 (recruitPos.y - diPos.y) * (recruitPos.y - diPos.y));
-                    if (distanceToDi < 20 && !diLatched && lastCatchCheck >= catchCooldown) {
-                        diLatched = true;
-                        latchTimer = 0;
-                        catchCount++;  // Increment catch count only once per latch
-                        lastCatchCheck = 0;
-                        if (diYell) Mix_PlayChannel(-1, diYell, 0);
-                        std::cout << "DI caught you! Times caught: " << catchCount << "/15\n";
-                        if (catchCount >= maxCatches) {
-                            running = false;
-                            std::cout << "DI won! You strip your blouse and head to the sand pit. Game Over!\n";
-                            continue;
-                        }
-                    }
-                }
+        jobs.wait(dustUpdated);
+        Vector2 leadPos = state.recruits.position(0);
+        Vector2 cameraPos = cameraFor(leadPos);
+        if (state.storming) {
+            // Dust storm: dust kicked up around the recruit and blowing across the whole view
+            ParticleSystem& dust = gameRenderer->getDustParticles();
+            if (effectsRng.below(5) == 0) dust.spawn(Vector2(leadPos.x + SPRITE_SIZE / 2, leadPos.y + SPRITE_SIZE / 2));
+            int gusts = options.dustPerFrame > 0 ? options.dustPerFrame : (effectsRng.below(5) == 0 ? 1 : 0);
+            for (int i = 0; i < gusts; ++i) {
+                if (!dust.spawn(Vector2(effectsRng.below(WIDTH) + cameraPos.x, effectsRng.below(HEIGHT) + cameraPos.y))) break;  // Pool is full
             }
+        }
+    }
 
-            float gearDistance = std::sqrt((recruitPos.x - gearPos.x) * (recruitPos.x - gearPos.x) +
-                                         (recruitPos.y - gearPos.y) * (recruitPos.y - gearPos.y));
-            if (gearDistance < 20 && !gearCollected) {
-                gearCollected = true;
-                std::cout << "Gear collected! DI backs off... for now.\n";
-                if (diLatched) {
-                    diLatched = false;
-                    latchTimer = 0;
-                    diPos = Vector2(diPos.x + random() % 200 - 100, diPos.y + random() % 200 - 100);  // DI backs off further
-                }
-            }
+    // Snapshot what render() interpolates from, taken before every tick
+    void savePreviousState() {
+        const RecruitPlatoon& recruits = sim.state().recruits;
+        const DrillInstructorSwarm& drillInstructors = sim.state().drillInstructors;
+        previousRecruitX.assign(recruits.xs(), recruits.xs() + recruits.size());
+        previousRecruitY.assign(recruits.ys(), recruits.ys() + recruits.size());
+        previousDiX.assign(drillInstructors.xs(), drillInstructors.xs() + drillInstructors.size());
+        previousDiY.assign(drillInstructors.ys(), drillInstructors.ys() + drillInstructors.size());
+    }
 
-            if (direction.x != 0 || direction.y != 0 && frameCount % 10 == 0 && !diLatched) {
-                recruitFrame = (recruitFrame + 1) % 4;
-                if (footsteps) Mix_PlayChannel(-1, footsteps, 0);
-            }
-            if (!gearCollected && frameCount % 15 == 0 && !diLatched) diFrame = (diFrame + 1) % 2;
+    void render(float alpha) {
+        // Draw the world partway between the last two ticks; the HUD shows the current state
+        const SimState& state = sim.state();
+        const RecruitPlatoon& recruits = state.recruits;
+        const DrillInstructorSwarm& drillInstructors = state.drillInstructors;
+        drawRecruitX.resize(recruits.size());
+        drawRecruitY.resize(recruits.size());
+        for (int i = 0; i < recruits.size(); ++i) {
+            drawRecruitX[i] = previousRecruitX[i] + (recruits.xs()[i] - previousRecruitX[i]) * alpha;
+            drawRecruitY[i] = previousRecruitY[i] + (recruits.ys()[i] - previousRecruitY[i]) * alpha;
+        }
+        drawGearX.clear();
+        drawGearY.clear();
+        for (int i = 0; i < state.objectives.size(); ++i) {
+            if (state.objectives.isCollected(i)) continue;
+            drawGearX.push_back(state.objectives.xs()[i]);
+            drawGearY.push_back(state.objectives.ys()[i]);
+        }
+        const float* diX = drillInstructors.xs();
+        const float* diY = drillInstructors.ys();
+        drawDiX.resize(drillInstructors.size());
+        drawDiY.resize(drillInstructors.size());
+        for (int i = 0; i < drillInstructors.size(); ++i) {
+            drawDiX[i] = previousDiX[i] + (diX[i] - previousDiX[i]) * alpha;
+            drawDiY[i] = previousDiY[i] + (diY[i] - previousDiY[i]) * alpha;
+        }
 
-            // Use EST-based day/night cycle instead of simple toggle
-            float dayNightCycle = gameRenderer->getDayNightFactor();
-            if (frameCount % 600 == 0) weatherTimer = 120;
-            if (weatherTimer > 0) {
-                weatherTimer--;
-                if (random() % 5 == 0) gameRenderer->addParticle(Vector2(recruitPos.x + SPRITE_SIZE / 2, recruitPos.y + SPRITE_SIZE / 2));
-            }
+        // Pass the animation frames to renderScene; the camera and stamina bar follow recruit 0
+        gameRenderer->setCamera(cameraFor(Vector2(drawRecruitX[0], drawRecruitY[0])));
+        JobCounter hudQueued;
+        jobs.submit([this] { queueHudText(); }, hudQueued);  // Laid out on a worker while the scene draws
+        if (options.dirtyRects) {  // renderScene() repaints the damage first thing, the HUD's share included
+            jobs.wait(hudQueued);
+            for (const SDL_Rect& rect : textRenderer->queuedRects()) gameRenderer->markDirty(rect);
+            gameRenderer->markDirty(profiler.overlayBounds());
+        }
+        {
+            ProfileScope scope(&profiler, PHASE_RENDER_SCENE);
+            gameRenderer->renderScene(drawRecruitX.data(), drawRecruitY.data(), recruits.frames(), recruits.size(), drawDiX.data(), drawDiY.data(),
+                                      state.gearCollected ? 0 : drillInstructors.size(), drawGearX.data(), drawGearY.data(), static_cast<int>(drawGearX.size()),
+                                      recruits.getStamina(0), -1.0f, state.diFrame);
+        }
+        jobs.wait(hudQueued);
+        textRenderer->flush();
+        if (overlayText) profiler.drawOverlay(renderer, *overlayText);
+    }
 
-            for (auto it = gameRenderer->getDustParticles().begin(); it != gameRenderer->getDustParticles().end();) {
-                it->y += 1;
-                if (it->y > cameraPos.y + HEIGHT || it->x < cameraPos.x || it->x > cameraPos.x + WIDTH) {
-                    it = gameRenderer->getDustParticles().erase(it);
-                } else {
-                    ++it;
-                }
-            }
+    // Queue the HUD strings into the TextRenderer batch. Makes no SDL calls, so it can run on a worker.
+    void queueHudText() {
+        ProfileScope scope(&profiler, PHASE_HUD_TEXT);
+        const SimState& state = sim.state();
+        if (state.diNearby) {
+            textRenderer->drawTextWithShadow("You look like the monkey off Ace Ventura!", BLACK, WHITE, 10, HEIGHT - 102);
+        }
+        if (state.gearCollected) {
+            textRenderer->drawTextWithShadow("Mission Complete: Gear Secured!", BLACK, WHITE, 10, HEIGHT - 62);
+        }
+        std::string catchStr = "Times Caught: " + std::to_string(state.catchCount) + "/" + std::to_string(MAX_CATCHES);
+        textRenderer->drawTextWithShadow(catchStr, BLACK, WHITE, 10, 40);
+
+        // Display escape prompt while latched
+        if (state.recruits.heldCount() > 0) {
+            int textW, textH;
+            textRenderer->measureText("Press Space to Escape!", &textW, &textH);
+            textRenderer->drawText("Press Space to Escape!", WHITE, (WIDTH - textW) / 2, HEIGHT - 150);
+        }
+        messages.update(SDL_GetTicks());
+        messages.draw(*textRenderer);
+    }
 
-            frameCount++;
-            lastCatchCheck++;
+    void present() {
+        ProfileScope scope(&profiler, PHASE_PRESENT);
+        gameRenderer->present();  // Ensure all rendering (including text) is displayed; blocks here with vsync
+    }
 
-            // Pass recruitFrame and diFrame to renderScene for animation
-            gameRenderer->setCamera(cameraPos);
-            gameRenderer->renderScene(recruitPos, diPos, gearPos, gearCollected, stamina, catchCount, frameCount, weatherTimer, dayNightCycle, recruitFrame, diFrame);
+    void writeProfile() {
+        if (profiler.writeChromeTrace("profile_trace.json") && profiler.writeCsv("profile.csv")) {
+            std::cout << "Profile written to profile_trace.json and profile.csv\n";
+        } else {
+            std::cerr << "Failed to write profile" << std::endl;
+        }
+    }
 
-            // Text rendering (ensure font and renderer are correct)
-            float distanceToDi = std::sqrt((recruitPos.x - diPos.x) * (recruitPos.x - diPos.x) +
-                                         (recruitPos.y - diPos.y) * (recruitPos.y - diPos.y));
-            if (!gearCollected && distanceToDi < 100 && !diLatched) {
-                SDL_Texture* diText = renderText("You look like the monkey off Ace Ventura!", BLACK);
-                SDL_Texture* diShadow = renderText("You look like the monkey off Ace Ventura!", WHITE);
-                if (diText && diShadow) {
-                    int textW, textH;
-                    SDL_QueryTexture(diText, NULL, NULL, &textW, &textH);
-                    SDL_Rect shadowRect = {12, HEIGHT - 100, textW, textH};
-                    SDL_Rect textRect = {10, HEIGHT - 102, textW, textH};
-                    SDL_RenderCopy(renderer, diShadow, NULL, &shadowRect);
-                    SDL_RenderCopy(renderer, diText, NULL, &textRect);
-                    SDL_DestroyTexture(diText);
-                    SDL_DestroyTexture(diShadow);
-                }
-            }
-            if (gearCollected) {
-                SDL_Texture* missionText = renderText("Mission Complete: Gear Secured!", BLACK);
-                SDL_Texture* missionShadow = renderText("Mission Complete: Gear Secured!", WHITE);
-                if (missionText && missionShadow) {
-                    int textW, textH;
-                    SDL_QueryTexture(missionText, NULL, NULL, &textW, &textH);
-                    SDL_Rect shadowRect = {12, HEIGHT - 60, textW, textH};
-                    SDL_Rect textRect = {10, HEIGHT - 62, textW, textH};
-                    SDL_RenderCopy(renderer, missionShadow, NULL, &shadowRect);
-                    SDL_RenderCopy(renderer, missionText, NULL, &textRect);
-                    SDL_DestroyTexture(missionText);
-                    SDL_DestroyTexture(missionShadow);
-                }
+public:
+    void run() {
+        savePreviousState();
+        frameClock.reset();
+        while (running) {
+            profiler.beginFrame();
+            Uint64 frameStart = SDL_GetPerformanceCounter();
+            handleEvents();
+            int ticks = frameClock.advance();
+            for (int i = 0; i < ticks && running; ++i) {
+                savePreviousState();
+                step();
             }
-            std::string catchStr = "Times Caught: " + std::to_string(catchCount) + "/15";
-            SDL_Texture* catchText = renderText(catchStr, BLACK);
-            SDL_Texture* catchShadow = renderText(catchStr, WHITE);
-            if (catchText && catchShadow) {
-                int textW, textH;
-                SDL_QueryTexture(catchText, NULL, NULL, &textW, &textH);
-                SDL_Rect shadowRect = {12, 42, textW, textH};
-                SDL_Rect textRect = {10, 40, textW, textH};
-                SDL_RenderCopy(renderer, catchShadow, NULL, &shadowRect);
-                SDL_RenderCopy(renderer, catchText, NULL, &textRect);
-                SDL_DestroyTexture(catchText);
-                SDL_DestroyTexture(catchShadow);
+            render(frameClock.alpha());
+            if (options.frameBudgetMs > 0) {  // Sampled before present(), which blocks on vsync: only the frame's own work counts
+                float frameMs = static_cast<float>(static_cast<double>(SDL_GetPerformanceCounter() - frameStart) * 1000.0 / SDL_GetPerformanceFrequency());
+                gameRenderer->setResolutionScale(resolutionScaler.update(frameMs));
             }
+            present();
+            frameClock.waitForNextFrame();
+            profiler.endFrame();  // Includes the wait, so the graph shows the real frame period
+        }
+        finishReplay();
+    }
 
-            // Display escape prompt while latched
-            if (diLatched) {
-                SDL_Texture* escapePrompt = renderText("Press Space to Escape!", WHITE);
-                if (escapePrompt) {
-                    int textW, textH;
-                    SDL_QueryTexture(escapePrompt, NULL, NULL, &textW, &textH);
-                    SDL_Rect promptRect = {(WIDTH - textW) / 2, HEIGHT - 150, textW, textH};
-                    SDL_RenderCopy(renderer, escapePrompt, NULL, &promptRect);
-                    SDL_DestroyTexture(escapePrompt);
-                }
+private:
+    void finishReplay() {
+        if (!options.replayPath.empty()) {
+            if (!replay.finished()) {
+                std::cout << "Replay stopped at tick " << sim.state().tick << " of " << replay.tickCount() << "\n";
+            } else if (replay.verify(sim)) {
+                std::cout << "Replay verified: " << replay.tickCount() << " ticks, checksum " << std::hex << sim.checksum() << std::dec << "\n";
+            } else {
+                exitStatus = 1;
             }
+        } else if (!options.recordPath.empty()) {
+            replay.finish(sim);
+            if (replay.save(options.recordPath)) std::cout << "Recorded " << replay.tickCount() << " ticks to " << options.recordPath << "\n";
+        }
+    }
+};
 
-            SDL_RenderPresent(renderer);  // Ensure all rendering (including text) is displayed
+// Stand-in player for headless runs: leads the platoon to the nearest gear, sprints while fresh,
+// struggles when caught
+static SimInput headlessInput(const SimState& state) {
+    SimInput input;
+    Vector2 lead = state.recruits.position(0);
+    float dx = 0, dy = 0, nearest = -1;
+    for (int i = 0; i < state.objectives.size(); ++i) {
+        if (state.objectives.isCollected(i) && state.objectives.remainingCount() > 0) continue;  // Once all are in, stay by them
+        Vector2 gear = state.objectives.position(i);
+        float distance = (gear.x - lead.x) * (gear.x - lead.x) + (gear.y - lead.y) * (gear.y - lead.y);
+        if (nearest < 0 || distance < nearest) {
+            nearest = distance;
+            dx = gear.x - lead.x;
+            dy = gear.y - lead.y;
+        }
+    }
+    input.moveX = dx > 1 ? 1 : (dx < -1 ? -1 : 0);
+    input.moveY = dy > 1 ? 1 : (dy < -1 ? -1 : 0);
+    input.sprint = state.recruits.getStamina(0) > 50.0f;
+    input.escape = state.recruits.heldCount() > 0 && state.tick % 10 == 0;
+    return input;
+}
 
-            SDL_Delay(16);  // Cap frame rate (60 FPS)
+// Run the simulation without a window, audio or frame pacing and report the outcome. Plays a
+// recorded session (--replay) at full speed and checks its end state, or drives the stand-in player.
+static int runHeadless(const GameOptions& options) {
+    WorldMap world;
+    SimCore sim;
+    InputReplay replay;
+    bool playback = !options.replayPath.empty();
+    if (playback && !replay.load(options.replayPath)) return 1;
+    Uint64 seed = playback ? replay.seed() : options.seed;
+    int drillInstructorCount = playback ? replay.drillInstructorCount() : options.drillInstructorCount;
+    int recruitCount = playback ? replay.recruitCount() : options.recruitCount;
+    int objectiveCount = playback ? replay.objectiveCount() : options.objectiveCount;
+    int tickLimit = playback ? replay.tickCount() : options.headlessTicks;
+    if (!world.load("maps/parris_island.pim") || !sim.init(&world, drillInstructorCount, seed, recruitCount, objectiveCount)) return 1;
+    if (!playback && !options.recordPath.empty()) replay.start(seed, drillInstructorCount, recruitCount, objectiveCount);
+    Uint64 start = SDL_GetPerformanceCounter();
+    int ticks = 0;
+    int gearTick = -1;
+    SimInput input;
+    while (ticks < tickLimit && !sim.state().gameOver) {
+        if (playback) replay.next(input);
+        else input = headlessInput(sim.state());
+        if (!playback && !options.recordPath.empty()) replay.record(input);
+        sim.step(input);
+        ticks++;
+        if (gearTick < 0 && sim.state().gearCollected) gearTick = ticks;
+    }
+    double seconds = static_cast<double>(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+    const SimState& state = sim.state();
+    std::cout << "Seed " << seed << ": " << ticks << " ticks in " << seconds * 1000.0 << " ms ("
+              << (seconds > 0 ? ticks / seconds : 0.0) << " ticks/s)\n"
+              << "Caught " << state.catchCount << "/" << MAX_CATCHES << (state.gameOver ? ", game over" : "")
+              << ", gear " << (gearTick >= 0 ? "collected at tick " + std::to_string(gearTick) : std::string("not collected")) << "\n"
+              << "Checksum " << std::hex << sim.checksum() << std::dec << std::endl;
+    if (playback) {
+        if (!replay.finished() || !replay.verify(sim)) {
+            std::cerr << "Replay " << options.replayPath << " did not reproduce its recorded end state" << std::endl;
+            return 1;
         }
+        std::cout << "Replay verified\n";
+    } else if (!options.recordPath.empty()) {
+        replay.finish(sim);
+        if (!replay.save(options.recordPath)) return 1;
+        std::cout << "Recorded " << replay.tickCount() << " ticks to " << options.recordPath << "\n";
     }
-};
+    return 0;
+}
 
 int main(int argc, char* argv[]) {
-    ParrisIslandTrials game;
+    GameOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dis" && i + 1 < argc) {
+            options.drillInstructorCount = std::clamp(std::atoi(argv[++i]), 1, MAX_DRILL_INSTRUCTORS);
+        } else if (arg == "--recruits" && i + 1 < argc) {
+            options.recruitCount = std::clamp(std::atoi(argv[++i]), 1, MAX_RECRUITS);
+        } else if (arg == "--objectives" && i + 1 < argc) {
+            options.objectiveCount = std::clamp(std::atoi(argv[++i]), 1, MAX_OBJECTIVES);
+        } else if (arg == "--dust" && i + 1 < argc) {
+            options.dustPerFrame = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--uncapped") {
+            options.pacing = PACING_UNCAPPED;
+        } else if (arg == "--fps" && i + 1 < argc) {
+            options.pacing = PACING_TARGET;
+            options.targetFps = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+            options.seedGiven = true;
+        } else if (arg == "--headless" && i + 1 < argc) {
+            options.headlessTicks = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--record" && i + 1 < argc) {
+            options.recordPath = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            options.replayPath = argv[++i];
+        } else if (arg == "--speed" && i + 1 < argc) {
+            options.replaySpeed = std::max(0.01, std::atof(argv[++i]));
+        } else if (arg == "--dirty-rects") {
+            options.dirtyRects = true;
+        } else if (arg == "--blitter") {
+            options.softwareBlit = true;
+        } else if (arg == "--frame-budget" && i + 1 < argc) {
+            options.frameBudgetMs = static_cast<float>(std::max(0.0, std::atof(argv[++i])));
+        } else {
+            std::cerr << "Unknown option: " << arg << "\nUsage: " << argv[0] << " [--dis N] [--recruits N] [--objectives N] [--dust N] [--uncapped | --fps N] [--seed N] [--headless TICKS] [--dirty-rects | --blitter | --frame-budget MS]"
+                      << " [--record FILE] [--replay FILE [--speed X]]"
+                      << "\n--recruits moves a whole platoon with the same input; the camera and stamina bar follow recruit 0" << std::endl;
+            return 1;
+        }
+    }
+    if (options.headlessTicks > 0 || (!options.replayPath.empty() && options.replaySpeed == 0.0)) return runHeadless(options);
+    ParrisIslandTrials game(options);
     if (game.isRunning()) game.run();
-    return 0;
+    return game.getExitStatus();
 }
@@ -0,0 +1,69 @@
+#include "particle_system.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cstring>
+
+ParticleSystem::ParticleSystem(int capacity) : posX(capacity), posY(capacity) {
+    drawRects.reserve(capacity);
+}
+
+// Add a particle at pos (map coordinates). Returns false if the pool is full.
+bool ParticleSystem::spawn(Vector2 pos) {
+    if (count == capacity()) return false;
+    posX[count] = pos.x;
+    posY[count] = pos.y;
+    count++;
+    return true;
+}
+
+// Let every particle fall one pixel and drop those that left view. Each range of PARTICLE_JOB_GRAIN
+// particles is integrated and compacted on its own (possibly on another thread), then the ranges'
+// survivors are moved together so the pool stays dense.
+void ParticleSystem::update(const SDL_Rect& view, JobSystem* jobs) {
+    const float left = static_cast<float>(view.x), right = static_cast<float>(view.x + view.w);
+    const float bottom = static_cast<float>(view.y + view.h);
+    int ranges = (count + PARTICLE_JOB_GRAIN - 1) / PARTICLE_JOB_GRAIN;
+    rangeLive.resize(ranges);
+    auto integrate = [&](int firstRange, int lastRange) {
+        for (int r = firstRange; r < lastRange; ++r) {
+            int live = r * PARTICLE_JOB_GRAIN;
+            int end = std::min(count, live + PARTICLE_JOB_GRAIN);
+            for (int i = live; i < end; ++i) {
+                float x = posX[i], y = posY[i] + 1;
+                if (y > bottom || x < left || x > right) continue;
+                posX[live] = x;
+                posY[live] = y;
+                live++;
+            }
+            rangeLive[r] = live - r * PARTICLE_JOB_GRAIN;
+        }
+    };
+    if (jobs) jobs->parallelFor(ranges, 1, integrate);
+    else integrate(0, ranges);
+
+    int live = ranges > 0 ? rangeLive[0] : 0;
+    for (int r = 1; r < ranges; ++r) {
+        if (rangeLive[r] == 0) continue;
+        std::memmove(&posX[live], &posX[r * PARTICLE_JOB_GRAIN], rangeLive[r] * sizeof(float));
+        std::memmove(&posY[live], &posY[r * PARTICLE_JOB_GRAIN], rangeLive[r] * sizeof(float));
+        live += rangeLive[r];
+    }
+    count = live;
+}
+
+// Where every particle lands on screen with the camera at cameraPos
+const std::vector<SDL_Rect>& ParticleSystem::screenRects(Vector2 cameraPos) {
+    drawRects.resize(count);
+    for (int i = 0; i < count; ++i) {
+        drawRects[i] = {static_cast<int>(posX[i] - cameraPos.x), static_cast<int>(posY[i] - cameraPos.y), DUST_PARTICLE_SIZE, DUST_PARTICLE_SIZE};
+    }
+    return drawRects;
+}
+
+// Draw every particle with one color and a single SDL_RenderFillRects call
+void ParticleSystem::draw(SDL_Renderer* renderer, Vector2 cameraPos, SDL_Color color) {
+    if (count == 0) return;
+    screenRects(cameraPos);
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    SDL_RenderFillRects(renderer, drawRects.data(), count);
+}
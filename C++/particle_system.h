@@ -0,0 +1,34 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include "common.h"
+#include <vector>
+
+class JobSystem;
+
+const int MAX_DUST_PARTICLES = 32768;
+const int DUST_PARTICLE_SIZE = 8;
+const int PARTICLE_JOB_GRAIN = 4096;  // Particles integrated per job
+
+// Fixed-capacity particle pool in structure-of-arrays form. The pool is updated once per tick by the
+// game (in ranges spread over a JobSystem when one is given) and drawn by the Renderer in a single
+// batched call.
+class ParticleSystem {
+private:
+    std::vector<float> posX, posY;
+    std::vector<SDL_Rect> drawRects;  // Scratch buffer for the batched draw
+    std::vector<int> rangeLive;       // Survivors per update range
+    int count = 0;
+
+public:
+    explicit ParticleSystem(int capacity = MAX_DUST_PARTICLES);
+    bool spawn(Vector2 pos);
+    void update(const SDL_Rect& view, JobSystem* jobs = nullptr);
+    const std::vector<SDL_Rect>& screenRects(Vector2 cameraPos);
+    void draw(SDL_Renderer* renderer, Vector2 cameraPos, SDL_Color color);
+    void clear() { count = 0; }
+    int size() const { return count; }
+    int capacity() const { return static_cast<int>(posX.size()); }
+};
+
+#endif // PARTICLE_SYSTEM_H
@@ -0,0 +1,144 @@
+#include "profiler.h"
+#include "text_renderer.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+const float OVERLAY_BUDGET_MS = 1000.0f / 60.0f;  // Frames slower than this are drawn red in the graph
+const int OVERLAY_WIDTH = 2 * PROFILE_HISTORY + 20;
+const int OVERLAY_GRAPH_HEIGHT = 60;               // Pixels for two frame budgets
+const int OVERLAY_LINE_HEIGHT = 18;
+const int OVERLAY_TEXT_LINES = PHASE_COUNT + 2;    // Frame time, the phases and the overlap note
+
+static std::atomic<Uint32> nextThreadId{1};
+
+// Id of the calling thread in samples, assigned the first time it records
+static Uint32 profileThreadId() {
+    thread_local Uint32 id = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+Profiler::Profiler() : ring(PROFILE_RING_SIZE) {
+    for (auto& total : phaseTotals) total.store(0);
+    frequency = SDL_GetPerformanceFrequency();
+    graphBars.reserve(PROFILE_HISTORY);
+    profileThreadId();  // The thread that creates the profiler, the main loop's, gets the first id
+}
+
+void Profiler::beginFrame() {
+    frameStart = SDL_GetPerformanceCounter();
+}
+
+// Close the frame: move this frame's per-phase totals into the overlay history
+void Profiler::endFrame() {
+    Uint64 now = SDL_GetPerformanceCounter();
+    const float toMs = 1000.0f / frequency;
+    frameMs[historyPos] = (now - frameStart) * toMs;
+    for (int p = 0; p < PHASE_COUNT; ++p) phaseMs[p][historyPos] = phaseTotals[p].exchange(0, std::memory_order_relaxed) * toMs;
+    historyPos = (historyPos + 1) % PROFILE_HISTORY;
+    frame.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Claim a slot, write the sample, then publish it by storing its sequence number (seqlock style),
+// so readers can tell finished samples from ones still being written or already overwritten
+void Profiler::record(ProfilePhase phase, Uint64 start, Uint64 end) {
+    Uint64 index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = ring[index & (PROFILE_RING_SIZE - 1)];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.sample = {start, end, frame.load(std::memory_order_relaxed), static_cast<Uint32>(phase), profileThreadId()};
+    slot.sequence.store(index + 1, std::memory_order_release);
+    phaseTotals[phase].fetch_add(end - start, std::memory_order_relaxed);
+}
+
+// Every complete sample still in the ring, oldest first
+const std::vector<ProfileSample>& Profiler::snapshot() {
+    exported.clear();
+    Uint64 last = head.load(std::memory_order_acquire);
+    Uint64 first = last > static_cast<Uint64>(PROFILE_RING_SIZE) ? last - PROFILE_RING_SIZE : 0;
+    for (Uint64 index = first; index < last; ++index) {
+        const Slot& slot = ring[index & (PROFILE_RING_SIZE - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1) continue;
+        ProfileSample sample = slot.sample;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == index + 1) exported.push_back(sample);
+    }
+    return exported;
+}
+
+SDL_Rect Profiler::overlayBounds() const {
+    if (!overlayVisible) return {0, 0, 0, 0};
+    return {WIDTH - OVERLAY_WIDTH - 10, 10, OVERLAY_WIDTH, OVERLAY_TEXT_LINES * OVERLAY_LINE_HEIGHT + OVERLAY_GRAPH_HEIGHT + 20};
+}
+
+// Per-phase averages over the last PROFILE_HISTORY frames and a frame-time graph, top right
+void Profiler::drawOverlay(SDL_Renderer* renderer, TextRenderer& text) {
+    if (!overlayVisible) return;
+    const SDL_Rect panel = overlayBounds();
+    const int x = panel.x, y = panel.y;
+    const int textHeight = OVERLAY_TEXT_LINES * OVERLAY_LINE_HEIGHT;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+    SDL_RenderFillRect(renderer, &panel);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    char line[64];
+    float averageFrame = 0.0f;
+    for (float ms : frameMs) averageFrame += ms / PROFILE_HISTORY;
+    std::snprintf(line, sizeof(line), "frame %6.2f ms (%.0f fps)", averageFrame, averageFrame > 0 ? 1000.0f / averageFrame : 0.0f);
+    text.drawText(line, WHITE, x + 10, y + 5);
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        float average = 0.0f;
+        for (float ms : phaseMs[p]) average += ms / PROFILE_HISTORY;
+        std::snprintf(line, sizeof(line), "%-13s %6.2f ms", PHASE_NAMES[p], average);
+        text.drawText(line, WHITE, x + 10, y + 5 + (p + 1) * OVERLAY_LINE_HEIGHT);
+    }
+    text.drawText("phase sum can exceed frame", WHITE, x + 10, y + 5 + (PHASE_COUNT + 1) * OVERLAY_LINE_HEIGHT);
+
+    // Oldest frame on the left; in-budget bars first, then the slow ones in red
+    const int baseline = y + textHeight + 10 + OVERLAY_GRAPH_HEIGHT;
+    for (int pass = 0; pass < 2; ++pass) {
+        graphBars.clear();
+        for (int i = 0; i < PROFILE_HISTORY; ++i) {
+            float ms = frameMs[(historyPos + i) % PROFILE_HISTORY];
+            if ((ms > OVERLAY_BUDGET_MS) != (pass == 1)) continue;
+            int height = std::min(OVERLAY_GRAPH_HEIGHT, static_cast<int>(ms * OVERLAY_GRAPH_HEIGHT / (2 * OVERLAY_BUDGET_MS)));
+            graphBars.push_back({x + 10 + 2 * i, baseline - height, 2, height});
+        }
+        SDL_Color color = pass == 0 ? GREEN : SDL_Color{255, 0, 0, 255};
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+        if (!graphBars.empty()) SDL_RenderFillRects(renderer, graphBars.data(), static_cast<int>(graphBars.size()));
+    }
+    text.flush();
+}
+
+// Trace Event Format, loadable in chrome://tracing and Perfetto: one complete ("X") event per sample,
+// on the track of the thread that recorded it so events on a track nest
+bool Profiler::writeChromeTrace(const std::string& path) {
+    const std::vector<ProfileSample>& samples = snapshot();
+    Uint64 origin = samples.empty() ? 0 : samples.front().start;
+    for (const auto& sample : samples) origin = std::min(origin, sample.start);
+    const double toUs = 1e6 / frequency;
+    std::ofstream out(path);
+    out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const ProfileSample& sample = samples[i];
+        out << "{\"name\":\"" << PHASE_NAMES[sample.phase] << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":" << sample.thread
+            << ",\"ts\":" << (sample.start - origin) * toUs << ",\"dur\":" << (sample.end - sample.start) * toUs
+            << ",\"args\":{\"frame\":" << sample.frame << "}}" << (i + 1 < samples.size() ? ",\n" : "\n");
+    }
+    out << "],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(out);
+}
+
+bool Profiler::writeCsv(const std::string& path) {
+    const std::vector<ProfileSample>& samples = snapshot();
+    const double toUs = 1e6 / frequency;
+    std::ofstream out(path);
+    out << std::fixed << std::setprecision(3) << "frame,thread,phase,start_us,duration_us\n";
+    for (const auto& sample : samples) {
+        out << sample.frame << "," << sample.thread << "," << PHASE_NAMES[sample.phase] << "," << sample.start * toUs << "," << (sample.end - sample.start) * toUs << "\n";
+    }
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,86 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "common.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+class TextRenderer;
+
+enum ProfilePhase {
+    PHASE_EVENTS,
+    PHASE_RECRUIT,
+    PHASE_DI_AI,
+    PHASE_PARTICLES,
+    PHASE_RENDER_SCENE,
+    PHASE_HUD_TEXT,
+    PHASE_PRESENT,
+    PHASE_COUNT
+};
+
+const char* const PHASE_NAMES[PHASE_COUNT] = {"events", "recruit", "di_ai", "particles", "render_scene", "hud_text", "present"};
+
+const int PROFILE_RING_SIZE = 1 << 16;  // Samples kept for export, a power of two
+const int PROFILE_HISTORY = 120;        // Frames shown in the overlay graph
+
+struct ProfileSample {
+    Uint64 start, end;  // SDL_GetPerformanceCounter ticks
+    Uint32 frame;
+    Uint32 phase;
+    Uint32 thread;      // Small per-thread id: 1 for the thread that created the Profiler, then in order of first record
+};
+
+// Phase timer for the main loop. Every timed scope is pushed into a lock-free ring buffer (any thread
+// may record) for Chrome trace / CSV export, and summed per frame for the on-screen overlay. Phases
+// that run on workers overlap the main thread's, so the totals can add up to more than the frame.
+class Profiler {
+private:
+    struct Slot {
+        std::atomic<Uint64> sequence{0};  // Index + 1 of the sample in this slot, 0 while being written
+        ProfileSample sample;
+    };
+    std::vector<Slot> ring;
+    std::atomic<Uint64> head{0};
+    std::atomic<Uint64> phaseTotals[PHASE_COUNT];  // Ticks spent in each phase this frame
+    std::atomic<Uint32> frame{0};
+    Uint64 frequency;
+    Uint64 frameStart = 0;
+    float frameMs[PROFILE_HISTORY] = {};
+    float phaseMs[PHASE_COUNT][PROFILE_HISTORY] = {};
+    int historyPos = 0;
+    std::vector<ProfileSample> exported;  // Scratch buffer for snapshot()
+    std::vector<SDL_Rect> graphBars;
+    bool overlayVisible = false;
+
+    const std::vector<ProfileSample>& snapshot();
+
+public:
+    Profiler();
+    void beginFrame();
+    void endFrame();
+    void record(ProfilePhase phase, Uint64 start, Uint64 end);
+    void toggleOverlay() { overlayVisible = !overlayVisible; }
+    void drawOverlay(SDL_Renderer* renderer, TextRenderer& text);
+    SDL_Rect overlayBounds() const;  // Empty while the overlay is hidden
+    bool writeChromeTrace(const std::string& path);
+    bool writeCsv(const std::string& path);
+};
+
+// Times the enclosing scope as one phase; does nothing without a profiler
+class ProfileScope {
+private:
+    Profiler* profiler;
+    ProfilePhase phase;
+    Uint64 start;
+
+public:
+    ProfileScope(Profiler* owner, ProfilePhase timedPhase) : profiler(owner), phase(timedPhase), start(owner ? SDL_GetPerformanceCounter() : 0) {}
+    ~ProfileScope() {
+        if (profiler) profiler->record(phase, start, SDL_GetPerformanceCounter());
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#endif // PROFILER_H
@@ -2,268 +2,606 @@
 #include <iostream>
 #include <cmath>
 #include <random>
+#include <algorithm>
 
-Renderer::Renderer(SDL_Window* win, SDL_Renderer* rend) : window(win), renderer(rend) {
+// Flat colors used when a structure category has no texture, per StructureCategory
+static const SDL_Color STRUCTURE_COLORS[CATEGORY_COUNT] = {BROWN, BROWN, DARK_SAND, GRASS, PAVEMENT, BROWN, GRAY, WATER};
+
+Renderer::Renderer(SDL_Window* win, SDL_Renderer* rend) : window(win), renderer(rend), spriteBatch(rend) {
     cameraPos = Vector2(0, 0);
-    barrackTexture = nullptr;
-    roadTexture = nullptr;
-    obstacleTexture = nullptr;
-    sandPitTexture = nullptr;
-    rifleRangeTexture = nullptr;
-    paradeDeckTexture = nullptr;
-    chowHallTexture = nullptr;
-    waterTexture = nullptr;
 }
 
+// Sprite textures belong to the atlas passed to setSprites(), only the chunk cache is ours
 Renderer::~Renderer() {
-    if (barrackTexture) SDL_DestroyTexture(barrackTexture);
-    if (roadTexture) SDL_DestroyTexture(roadTexture);
-    if (obstacleTexture) SDL_DestroyTexture(obstacleTexture);
-    if (sandPitTexture) SDL_DestroyTexture(sandPitTexture);
-    if (rifleRangeTexture) SDL_DestroyTexture(rifleRangeTexture);
-    if (paradeDeckTexture) SDL_DestroyTexture(paradeDeckTexture);
-    if (chowHallTexture) SDL_DestroyTexture(chowHallTexture);
-    if (waterTexture) SDL_DestroyTexture(waterTexture);
-    if (recruitTexture) SDL_DestroyTexture(recruitTexture);
-    if (diTexture) SDL_DestroyTexture(diTexture);
-    if (gearTexture) SDL_DestroyTexture(gearTexture);
-}
-
-void Renderer::initializeMap(const std::vector<SDL_Rect>& tiles, const std::vector<SDL_Rect>& buildings,
-                            const std::vector<SDL_Rect>& obstacles, const std::vector<SDL_Rect>& pits,
-                            const std::vector<SDL_Rect>& roadTiles, const std::vector<SDL_Rect>& ranges,
-                            const std::vector<SDL_Rect>& decks, const std::vector<SDL_Rect>& chows,
-                            const std::vector<SDL_Rect>& waters) {
-    mapTiles = tiles;
-    barracks = buildings;
-    obstacleCourses = obstacles;
-    sandPits = pits;
-    roads = roadTiles;
-    rifleRanges = ranges;
-    paradeDecks = decks;
-    chowHalls = chows;
-    waterAreas = waters;
-}
-
-void Renderer::setTextures(SDL_Texture* recruit, SDL_Texture* di, SDL_Texture* gear,
-                          SDL_Texture* barrack, SDL_Texture* road, SDL_Texture* obstacle,
-                          SDL_Texture* sandPit, SDL_Texture* rifleRange, SDL_Texture* paradeDeck,
-                          SDL_Texture* chowHall, SDL_Texture* water) {
-    recruitTexture = recruit;
-    diTexture = di;
-    gearTexture = gear;
-    barrackTexture = barrack ? barrack : nullptr;  // Optional textures
-    roadTexture = road ? road : nullptr;
-    obstacleTexture = obstacle ? obstacle : nullptr;
-    sandPitTexture = sandPit ? sandPit : nullptr;
-    rifleRangeTexture = rifleRange ? rifleRange : nullptr;
-    paradeDeckTexture = paradeDeck ? paradeDeck : nullptr;
-    chowHallTexture = chowHall ? chowHall : nullptr;
-    waterTexture = water ? water : nullptr;
+    destroyMapChunks();
+    if (background) SDL_DestroyTexture(background);
+    if (framebuffer) SDL_DestroyTexture(framebuffer);
+    if (worldTarget) SDL_DestroyTexture(worldTarget);
 }
 
-void Renderer::addParticle(Vector2 pos) {
-    dustParticles.push_back(pos);
+void Renderer::initializeMap(const WorldMap* map) {
+    destroyMapChunks();  // Waits for chunk jobs still reading the old map
+    world = map;
+    chunksDirty = true;
 }
 
-void Renderer::setCamera(Vector2 pos) {
-    cameraPos = pos;
+// Look up every sprite by name: animation frames, gear, and one terrain image per structure category
+void Renderer::setSprites(const TextureAtlas& spriteAtlas) {
+    destroyMapChunks();  // Waits for chunk jobs still reading the old sprites
+    for (const auto& sprite : recruitFrames) spriteBatch.forgetTexture(sprite.texture);  // Pages of a previous atlas
+    for (const auto& sprite : diFrames) spriteBatch.forgetTexture(sprite.texture);
+    for (const auto& sprite : structureSprites) spriteBatch.forgetTexture(sprite.texture);
+    spriteBatch.forgetTexture(gearSprite.texture);
+    atlas = &spriteAtlas;
+    for (int i = 0; i < RECRUIT_FRAMES; ++i) recruitFrames[i] = atlas->sprite("recruit_walk" + std::to_string(i + 1));
+    for (int i = 0; i < DI_FRAMES; ++i) diFrames[i] = atlas->sprite("di_yell" + std::to_string(i + 1));
+    gearSprite = atlas->sprite("gear");
+    for (int i = 0; i < CATEGORY_COUNT; ++i) structureSprites[i] = atlas->sprite(MAP_CATEGORY_NAMES[i]);  // Optional textures
+    pagesLight = nullptr;  // Relit from the new pages by the next renderScene()
+    chunksDirty = true;
 }
 
-std::vector<Vector2>& Renderer::getDustParticles() {
-    return dustParticles;
+void Renderer::destroyMapChunks() {
+    for (auto& job : chunkJobs) {
+        if (jobs) jobs->wait(job->counter);  // Its worker still reads the map and the sprite table
+    }
+    chunkJobs.clear();
+    for (int index : residentChunks) {
+        if (!mapChunks[index].texture) continue;  // Software blitter image
+        spriteBatch.forgetTexture(mapChunks[index].texture);  // A later texture may reuse the address with another size
+        SDL_DestroyTexture(mapChunks[index].texture);
+    }
+    residentChunks.clear();
+    mapChunks.clear();  // Frees the software chunk images too
+    chunkColumns = 0;
+    chunkRows = 0;
+    backgroundValid = false;
 }
 
-float Renderer::getDayNightFactor() {
-    // Get current time in EST (UTC-5)
-    time_t now = time(nullptr);
-    struct tm* local = localtime(&now);
-    int utc_offset = -5; // EST is UTC-5
-    local->tm_hour = (local->tm_hour + utc_offset + 24) % 24; // Adjust to EST
-
-    float hour = local->tm_hour + local->tm_min / 60.0f; // Hour as a float (e.g., 14:30 = 14.5)
-
-    // Define day/night periods (6 AM to 6 PM day, 6 PM to 6 AM night)
-    float sunrise = 6.0f;
-    float sunset = 18.0f;
-    float t;
-
-    if (hour >= sunrise && hour < sunset) {
-        // Daytime: interpolate from night (t=1) to day (t=0)
-        t = (hour - sunrise) / (sunset - sunrise);
-        t = 1.0f - t; // Reverse so 6 AM is full day (t=0), 6 PM is full night (t=1)
-    } else {
-        // Nighttime: interpolate across night period
-        float night_hours = (hour < sunrise) ? (hour + 24 - sunset) : (hour - sunset);
-        t = night_hours / (24.0f - (sunset - sunrise));
-        t = (t < 0.5f) ? 1.0f : 1.0f - ((t - 0.5f) * 2); // Smooth transition: 1 at 6 PM, 0 at midnight, 1 at 6 AM
+// Collect every structure rect inside view, offset so that view's corner lands at (0, 0), back to front
+// with one batch layer per category. Only reads the map and the sprite table, so it can run on a worker.
+void Renderer::collectMapQuads(const SDL_Rect& view, std::vector<SpriteQuad>& quads) const {
+    quads.clear();
+    if (!world) return;
+    static const StructureCategory drawOrder[] = {CATEGORY_WATER, CATEGORY_ROAD, CATEGORY_BARRACKS, CATEGORY_OBSTACLE,
+                                                  CATEGORY_SAND_PIT, CATEGORY_RIFLE_RANGE, CATEGORY_PARADE_DECK, CATEGORY_CHOW_HALL};
+    for (int i = 0; i < CATEGORY_COUNT; ++i) {
+        const AtlasSprite& sprite = structureSprites[drawOrder[i]];
+        SDL_Color tint = sprite.texture ? WHITE : STRUCTURE_COLORS[drawOrder[i]];  // Fallback to flat color
+        for (const auto& rect : world->rects(drawOrder[i])) {
+            if (!SDL_HasIntersection(&rect, &view)) continue;
+            SDL_Rect screenRect = {rect.x - view.x, rect.y - view.y, rect.w, rect.h};
+            quads.push_back({sprite.texture, LAYER_MAP + i, sprite.src, screenRect, tint});
+        }
     }
+}
 
-    return std::max(0.0f, std::min(1.0f, t)); // Clamp between 0 and 1
+// Queue all static structures inside view
+void Renderer::drawMapLayer(const SDL_Rect& view) {
+    collectMapQuads(view, mapQuads);
+    for (const auto& quad : mapQuads) spriteBatch.add(quad);
 }
 
-void Renderer::renderScene(Vector2 recruitPos, Vector2 diPos, Vector2 gearPos, bool gearCollected, float stamina, int catchCount, int frameCount, int weatherTimer, float dayNightCycle, int recruitFrame, int diFrame) {
-    float t = (dayNightCycle >= 0) ? dayNightCycle : getDayNightFactor();
+// Lay out the chunk grid over the map; streamMapChunks() renders the chunks as the camera nears them
+void Renderer::resetMapChunks() {
+    destroyMapChunks();
+    chunksDirty = false;
+    chunksCached = false;
 
-    // Interpolate between SAND (day) and NIGHT (night)
-    SDL_Color bgColor = {
-        static_cast<Uint8>((1 - t) * SAND.r + t * NIGHT.r),
-        static_cast<Uint8>((1 - t) * SAND.g + t * NIGHT.g),
-        static_cast<Uint8>((1 - t) * SAND.b + t * NIGHT.b),
-        255
-    };
-    SDL_SetRenderDrawColor(renderer, bgColor.r, bgColor.g, bgColor.b, bgColor.a);
-    SDL_RenderClear(renderer);
+    int mapW = world ? world->width() : 0;
+    int mapH = world ? world->height() : 0;
+    if (mapW <= 0 || mapH <= 0 || (!softwareBlit && !SDL_RenderTargetSupported(renderer))) return;
 
-    // Draw Parris Island map (tiles, water, roads, buildings, obstacles, sand pits, etc.) with textures
-    for (const auto& tile : mapTiles) {
-        SDL_Rect screenTile = {static_cast<int>(tile.x - cameraPos.x), static_cast<int>(tile.y - cameraPos.y), tile.w, tile.h};
-        if (screenTile.x + tile.w > 0 && screenTile.x < WIDTH && screenTile.y + tile.h > 0 && screenTile.y < HEIGHT) {
-            SDL_SetRenderDrawColor(renderer, bgColor.r, bgColor.g, bgColor.b, bgColor.a);  // Use interpolated background
-            SDL_RenderFillRect(renderer, &screenTile);
+    chunkColumns = (mapW + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+    chunkRows = (mapH + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+    mapChunks.resize(chunkColumns * chunkRows);
+    for (int row = 0; row < chunkRows; ++row) {
+        for (int col = 0; col < chunkColumns; ++col) {
+            mapChunks[row * chunkColumns + col].bounds = {col * MAP_CHUNK_SIZE, row * MAP_CHUNK_SIZE, MAP_CHUNK_SIZE, MAP_CHUNK_SIZE};
         }
     }
-    for (const auto& water : waterAreas) {
-        SDL_Rect screenWater = {static_cast<int>(water.x - cameraPos.x), static_cast<int>(water.y - cameraPos.y), water.w, water.h};
-        if (screenWater.x + screenWater.w > 0 && screenWater.x < WIDTH && screenWater.y + screenWater.h > 0 && screenWater.y < HEIGHT) {
-            if (waterTexture) {
-                SDL_RenderCopy(renderer, waterTexture, NULL, &screenWater);
-            } else {
-                SDL_SetRenderDrawColor(renderer, WATER.r, WATER.g, WATER.b, WATER.a);  // Fallback to color
-                SDL_RenderFillRect(renderer, &screenWater);
-            }
+    chunksCached = true;
+}
+
+// Target texture for one more resident chunk: a new one while under MAP_CHUNK_BUDGET, otherwise the
+// one of the least recently wanted chunk, which is evicted. nullptr if every resident chunk is still wanted.
+SDL_Texture* Renderer::acquireChunkTexture() {
+    if (static_cast<int>(residentChunks.size()) < MAP_CHUNK_BUDGET) {
+        SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, MAP_CHUNK_SIZE, MAP_CHUNK_SIZE);
+        if (!texture) {
+            std::cerr << "Failed to create map chunk, drawing map directly: " << SDL_GetError() << std::endl;
+            chunksCached = false;
+            return nullptr;
         }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        return texture;
     }
-    for (const auto& road : roads) {
-        SDL_Rect screenRoad = {static_cast<int>(road.x - cameraPos.x), static_cast<int>(road.y - cameraPos.y), road.w, road.h};
-        if (screenRoad.x + screenRoad.w > 0 && screenRoad.x < WIDTH && screenRoad.y + screenRoad.h > 0 && screenRoad.y < HEIGHT) {
-            if (roadTexture) {
-                SDL_RenderCopy(renderer, roadTexture, NULL, &screenRoad);
-            } else {
-                SDL_SetRenderDrawColor(renderer, GRAY.r, GRAY.g, GRAY.b, GRAY.a);  // Fallback to gray
-                SDL_RenderFillRect(renderer, &screenRoad);
-            }
+    int oldest = leastRecentlyWanted();
+    if (oldest < 0) return nullptr;
+    MapChunk& evicted = mapChunks[residentChunks[oldest]];
+    SDL_Texture* texture = evicted.texture;
+    evicted.texture = nullptr;
+    residentChunks[oldest] = residentChunks.back();
+    residentChunks.pop_back();
+    return texture;
+}
+
+// Position in residentChunks of the chunk wanted longest ago, or -1 if all of them are wanted this frame
+int Renderer::leastRecentlyWanted() const {
+    int oldest = -1;
+    for (size_t i = 0; i < residentChunks.size(); ++i) {
+        const MapChunk& chunk = mapChunks[residentChunks[i]];
+        if (chunk.lastWanted != chunkFrame && (oldest < 0 || chunk.lastWanted < mapChunks[residentChunks[oldest]].lastWanted)) {
+            oldest = static_cast<int>(i);
         }
     }
-    for (const auto& barrack : barracks) {
-        SDL_Rect screenBarrack = {static_cast<int>(barrack.x - cameraPos.x), static_cast<int>(barrack.y - cameraPos.y), barrack.w, barrack.h};
-        if (screenBarrack.x + screenBarrack.w > 0 && screenBarrack.x < WIDTH && screenBarrack.y + screenBarrack.h > 0 && screenBarrack.y < HEIGHT) {
-            if (barrackTexture) {
-                SDL_RenderCopy(renderer, barrackTexture, NULL, &screenBarrack);
-            } else {
-                SDL_SetRenderDrawColor(renderer, BROWN.r, BROWN.g, BROWN.b, BROWN.a);  // Fallback to brown
-                SDL_RenderFillRect(renderer, &screenBarrack);
-            }
+    return oldest;
+}
+
+// Software blitter counterpart of renderChunk(): keep a rasterized chunk, evicting the least recently
+// wanted image at MAP_CHUNK_BUDGET. false if every resident chunk is still wanted.
+bool Renderer::storeChunkImage(int index, PixelImage& image) {
+    if (static_cast<int>(residentChunks.size()) >= MAP_CHUNK_BUDGET) {
+        int oldest = leastRecentlyWanted();
+        if (oldest < 0) return false;
+        PixelImage().pixels.swap(mapChunks[residentChunks[oldest]].image.pixels);  // Actually release the memory
+        residentChunks[oldest] = residentChunks.back();
+        residentChunks.pop_back();
+    }
+    std::swap(mapChunks[index].image, image);
+    residentChunks.push_back(index);
+    return true;
+}
+
+// Atlas page holding texture among our structure sprites, -1 if none
+int Renderer::pageOf(SDL_Texture* texture) const {
+    for (const auto& sprite : structureSprites) {
+        if (sprite.texture == texture) return sprite.page;
+    }
+    return -1;
+}
+
+// Draw a chunk's quads over the lit ground with the software blitter. Reads only litPages and the
+// light, which stay put while chunk jobs exist (relightPages() waits for them), so it runs on workers.
+void Renderer::rasterizeChunk(const std::vector<SpriteQuad>& quads, PixelImage& image) const {
+    image.resize(MAP_CHUNK_SIZE, MAP_CHUNK_SIZE);
+    PixelView target = image.view();
+    blitter.fill(target, {0, 0, MAP_CHUNK_SIZE, MAP_CHUNK_SIZE}, packArgb(pagesLight->background));
+    for (const auto& quad : quads) {
+        int page = quad.texture ? pageOf(quad.texture) : -1;
+        if (page >= 0 && page < static_cast<int>(litPages.size())) {
+            blitter.blendScaled(target, quad.dst, litPages[page].view(), quad.src);
+        } else if (!quad.texture) {
+            blitter.fill(target, quad.dst, packArgb(modulate(quad.color, pagesLight->ambient)));
         }
     }
-    for (const auto& obstacle : obstacleCourses) {
-        SDL_Rect screenObstacle = {static_cast<int>(obstacle.x - cameraPos.x), static_cast<int>(obstacle.y - cameraPos.y), obstacle.w, obstacle.h};
-        if (screenObstacle.x + screenObstacle.w > 0 && screenObstacle.x < WIDTH && screenObstacle.y + screenObstacle.h > 0 && screenObstacle.y < HEIGHT) {
-            if (obstacleTexture) {
-                SDL_RenderCopy(renderer, obstacleTexture, NULL, &screenObstacle);
-            } else {
-                SDL_SetRenderDrawColor(renderer, BROWN.r, BROWN.g, BROWN.b, BROWN.a);  // Fallback to brown
-                SDL_RenderFillRect(renderer, &screenObstacle);
+}
+
+// Render quads into a texture for chunk index; false if no texture could be had
+bool Renderer::renderChunk(int index, const std::vector<SpriteQuad>& quads) {
+    SDL_Texture* texture = acquireChunkTexture();
+    if (!texture) return false;
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    if (SDL_SetRenderTarget(renderer, texture) < 0) {
+        std::cerr << "Failed to render map chunk, drawing map directly: " << SDL_GetError() << std::endl;
+        SDL_DestroyTexture(texture);
+        chunksCached = false;
+        return false;
+    }
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);  // Transparent, so the day/night ground shows through
+    SDL_RenderClear(renderer);
+    for (const auto& quad : quads) spriteBatch.add(quad);
+    spriteBatch.flush();  // While the chunk is still the render target
+    SDL_SetRenderTarget(renderer, previousTarget);
+    mapChunks[index].texture = texture;
+    residentChunks.push_back(index);
+    return true;
+}
+
+// Collect a chunk's quads on the job system (or right here without one); streamMapChunks() renders them.
+// For the software blitter the job rasterizes them as well.
+void Renderer::prepareChunk(int index) {
+    std::unique_ptr<ChunkJob> job(new ChunkJob());
+    job->chunk = index;
+    ChunkJob* pending = job.get();
+    SDL_Rect bounds = mapChunks[index].bounds;
+    mapChunks[index].preparing = true;
+    bool rasterize = softwareBlit;
+    auto work = [this, pending, bounds, rasterize] {
+        collectMapQuads(bounds, pending->quads);
+        if (rasterize) rasterizeChunk(pending->quads, pending->image);
+    };
+    if (jobs) {
+        jobs->submit(work, pending->counter);
+    } else {
+        work();
+    }
+    chunkJobs.push_back(std::move(job));
+}
+
+// Keep the chunks around view resident. Chunks within MAP_CHUNK_PREFETCH of it are prepared in the
+// background and rendered MAP_CHUNK_UPLOADS_PER_FRAME at a time, so they are usually ready before
+// they scroll in; a visible chunk that is still missing (first frame, a jump) is rendered right away.
+// Must run before anything else is queued in the sprite batch.
+void Renderer::streamMapChunks(const SDL_Rect& view) {
+    chunkFrame++;
+    SDL_Rect nearby = {view.x - MAP_CHUNK_PREFETCH, view.y - MAP_CHUNK_PREFETCH, view.w + 2 * MAP_CHUNK_PREFETCH, view.h + 2 * MAP_CHUNK_PREFETCH};
+    int firstCol = std::max(0, nearby.x / MAP_CHUNK_SIZE);
+    int firstRow = std::max(0, nearby.y / MAP_CHUNK_SIZE);
+    int lastCol = std::min(chunkColumns - 1, (nearby.x + nearby.w - 1) / MAP_CHUNK_SIZE);
+    int lastRow = std::min(chunkRows - 1, (nearby.y + nearby.h - 1) / MAP_CHUNK_SIZE);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) {
+            MapChunk& chunk = mapChunks[row * chunkColumns + col];
+            chunk.lastWanted = chunkFrame;  // Marked before anything is evicted below
+            if (!chunk.resident() && !chunk.preparing && !SDL_HasIntersection(&chunk.bounds, &view) &&
+                static_cast<int>(chunkJobs.size()) < MAP_CHUNK_JOBS) {
+                prepareChunk(row * chunkColumns + col);
             }
         }
     }
-    for (const auto& sandPit : sandPits) {
-        SDL_Rect screenSandPit = {static_cast<int>(sandPit.x - cameraPos.x), static_cast<int>(sandPit.y - cameraPos.y), sandPit.w, sandPit.h};
-        if (screenSandPit.x + screenSandPit.w > 0 && screenSandPit.x < WIDTH && screenSandPit.y + screenSandPit.h > 0 && screenSandPit.y < HEIGHT) {
-            if (sandPitTexture) {
-                SDL_RenderCopy(renderer, sandPitTexture, NULL, &screenSandPit);
-            } else {
-                SDL_SetRenderDrawColor(renderer, DARK_SAND.r, DARK_SAND.g, DARK_SAND.b, DARK_SAND.a);  // Fallback to dark sand
-                SDL_RenderFillRect(renderer, &screenSandPit);
+
+    for (int row = std::max(0, view.y / MAP_CHUNK_SIZE); row <= std::min(chunkRows - 1, (view.y + view.h - 1) / MAP_CHUNK_SIZE); ++row) {
+        for (int col = std::max(0, view.x / MAP_CHUNK_SIZE); col <= std::min(chunkColumns - 1, (view.x + view.w - 1) / MAP_CHUNK_SIZE); ++col) {
+            int index = row * chunkColumns + col;
+            if (mapChunks[index].resident()) continue;
+            collectMapQuads(mapChunks[index].bounds, mapQuads);
+            if (softwareBlit) {
+                PixelImage image;
+                rasterizeChunk(mapQuads, image);
+                if (!storeChunkImage(index, image)) return;
+            } else if (!renderChunk(index, mapQuads)) {
+                return;
             }
         }
     }
-    for (const auto& range : rifleRanges) {
-        SDL_Rect screenRange = {static_cast<int>(range.x - cameraPos.x), static_cast<int>(range.y - cameraPos.y), range.w, range.h};
-        if (screenRange.x + screenRange.w > 0 && screenRange.x < WIDTH && screenRange.y + screenRange.h > 0 && screenRange.y < HEIGHT) {
-            if (rifleRangeTexture) {
-                SDL_RenderCopy(renderer, rifleRangeTexture, NULL, &screenRange);
-            } else {
-                SDL_SetRenderDrawColor(renderer, GRASS.r, GRASS.g, GRASS.b, GRASS.a);  // Fallback to green grass
-                SDL_RenderFillRect(renderer, &screenRange);
-            }
+
+    int uploads = 0;
+    for (auto it = chunkJobs.begin(); it != chunkJobs.end();) {
+        ChunkJob& job = **it;
+        if (!job.counter.done()) {
+            ++it;
+            continue;
+        }
+        MapChunk& chunk = mapChunks[job.chunk];
+        if (chunk.resident() || chunk.lastWanted != chunkFrame) {  // Rendered in the meantime, or the camera moved away
+            chunk.preparing = false;
+            it = chunkJobs.erase(it);
+            continue;
         }
+        if (uploads == MAP_CHUNK_UPLOADS_PER_FRAME) break;
+        uploads++;
+        chunk.preparing = false;
+        bool rendered = softwareBlit ? storeChunkImage(job.chunk, job.image) : renderChunk(job.chunk, job.quads);
+        it = chunkJobs.erase(it);
+        if (!rendered) break;
     }
-    for (const auto& deck : paradeDecks) {
-        SDL_Rect screenDeck = {static_cast<int>(deck.x - cameraPos.x), static_cast<int>(deck.y - cameraPos.y), deck.w, deck.h};
-        if (screenDeck.x + screenDeck.w > 0 && screenDeck.x < WIDTH && screenDeck.y + screenDeck.h > 0 && screenDeck.y < HEIGHT) {
-            if (paradeDeckTexture) {
-                SDL_RenderCopy(renderer, paradeDeckTexture, NULL, &screenDeck);
-            } else {
-                SDL_SetRenderDrawColor(renderer, PAVEMENT.r, PAVEMENT.g, PAVEMENT.b, PAVEMENT.a);  // Fallback to white pavement
-                SDL_RenderFillRect(renderer, &screenDeck);
-            }
+}
+
+void Renderer::addParticle(Vector2 pos) {
+    dustParticles.spawn(pos);
+}
+
+void Renderer::setCamera(Vector2 pos) {
+    cameraPos = pos;
+}
+
+ParticleSystem& Renderer::getDustParticles() {
+    return dustParticles;
+}
+
+// Queue the static map inside view: the visible cached chunks, or the structures themselves without a cache
+void Renderer::queueMap(const SDL_Rect& view) {
+    if (!chunksCached) {
+        drawMapLayer(view);  // No render target support, draw visible structures directly
+        return;
+    }
+    int firstCol = std::max(0, view.x / MAP_CHUNK_SIZE);
+    int firstRow = std::max(0, view.y / MAP_CHUNK_SIZE);
+    int lastCol = std::min(chunkColumns - 1, (view.x + view.w - 1) / MAP_CHUNK_SIZE);
+    int lastRow = std::min(chunkRows - 1, (view.y + view.h - 1) / MAP_CHUNK_SIZE);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) {
+            const MapChunk& chunk = mapChunks[row * chunkColumns + col];
+            if (!chunk.texture) continue;
+            SDL_Rect screenChunk = {chunk.bounds.x - view.x, chunk.bounds.y - view.y, chunk.bounds.w, chunk.bounds.h};
+            spriteBatch.add(chunk.texture, NULL, screenChunk, LAYER_MAP);
         }
     }
-    for (const auto& chow : chowHalls) {
-        SDL_Rect screenChow = {static_cast<int>(chow.x - cameraPos.x), static_cast<int>(chow.y - cameraPos.y), chow.w, chow.h};
-        if (screenChow.x + screenChow.w > 0 && screenChow.x < WIDTH && screenChow.y + screenChow.h > 0 && screenChow.y < HEIGHT) {
-            if (chowHallTexture) {
-                SDL_RenderCopy(renderer, chowHallTexture, NULL, &screenChow);
-            } else {
-                SDL_SetRenderDrawColor(renderer, BROWN.r, BROWN.g, BROWN.b, BROWN.a);  // Fallback to brown
-                SDL_RenderFillRect(renderer, &screenChow);
+}
+
+// Queue a sprite above the map if any of it is on screen
+void Renderer::queueSprite(const AtlasSprite& sprite, const SDL_Rect& dst, int layer) {
+    if (dst.x + dst.w <= 0 || dst.x >= WIDTH || dst.y + dst.h <= 0 || dst.y >= HEIGHT) return;
+    if (softwareBlit) {
+        if (sprite.page >= 0) softSprites.push_back({sprite.page, sprite.src, dst});  // Queued in draw order already
+        return;
+    }
+    spriteBatch.add(sprite.texture, &sprite.src, dst, layer);
+    if (dirtyRects) drawnNow.add(dst);
+}
+
+// Partial redraw for software rendering, where every full-screen fill and copy costs. The ground and
+// the map are kept in a background texture, redrawn only when the camera or the light changes. Other
+// frames copy it back over just the tiles that last frame's or this frame's sprites, dust and HUD
+// cover, draw those on top and present only those tiles. Needs render targets (the software
+// renderer has them); returns false and keeps redrawing everything without. Only for a software
+// renderer created on the window surface, which present() then updates itself.
+bool Renderer::setDirtyRects(bool enabled) {
+    if (background) SDL_DestroyTexture(background);
+    background = nullptr;
+    windowSurface = enabled;
+    dirtyRects = false;
+    if (!enabled) return true;
+    Uint32 format = window ? SDL_GetWindowPixelFormat(window) : SDL_PIXELFORMAT_UNKNOWN;
+    if (format == SDL_PIXELFORMAT_UNKNOWN) format = SDL_PIXELFORMAT_RGBA8888;  // Matching the window's saves a conversion per copy
+    if (SDL_RenderTargetSupported(renderer)) background = SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_TARGET, WIDTH, HEIGHT);
+    if (!background) {
+        std::cerr << "Dirty rectangles unavailable, redrawing every frame: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    dirtyRects = true;
+    backgroundValid = false;
+    drawnNow.clear();
+    drawnBefore.clear();
+    return true;
+}
+
+// Compose the world (ground, map chunks, sprites, stamina bar and dust) on the CPU with the SoftBlitter
+// and hand the frame to the renderer as one streaming texture, for renderers whose own copies and
+// blends are slow. HUD text is still drawn by the renderer on top. Not combined with dirty rectangles,
+// which only pay off when most of the frame isn't redrawn; returns false without a framebuffer.
+bool Renderer::setSoftwareBlit(bool enabled) {
+    destroyMapChunks();  // Textures and images don't mix in one cache
+    if (framebuffer) SDL_DestroyTexture(framebuffer);
+    framebuffer = nullptr;
+    softwareBlit = false;
+    pagesLight = nullptr;
+    litPages.clear();
+    chunksDirty = true;
+    if (!enabled) return true;
+    if (dirtyRects) {
+        std::cerr << "Software blitter unavailable with dirty rectangles" << std::endl;
+        return false;
+    }
+    framebuffer = SDL_CreateTexture(renderer, SOFT_PIXEL_FORMAT, SDL_TEXTUREACCESS_STREAMING, WIDTH, HEIGHT);
+    if (!framebuffer) {
+        std::cerr << "Software blitter unavailable: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    softwareBlit = true;
+    std::cout << "Software blitter: " << blitter.kernelName() << " kernels" << std::endl;
+    return true;
+}
+
+// Draw the world (map, sprites, dust) at setResolutionScale() of the window's size into an offscreen
+// target and stretch it over the window, so the game can trade sharpness for frame time when the
+// scene gets heavy. The stamina bar and the text drawn after renderScene() stay at native resolution.
+// Needs render targets; not combined with dirty rectangles or the software blitter, which have
+// their own ways of saving fill rate. Returns false if unavailable.
+bool Renderer::setDynamicResolution(bool enabled) {
+    if (worldTarget) SDL_DestroyTexture(worldTarget);
+    worldTarget = nullptr;
+    resolutionScale = 1.0f;
+    if (!enabled) return true;
+    if (dirtyRects || softwareBlit) {
+        std::cerr << "Dynamic resolution unavailable with dirty rectangles or the software blitter" << std::endl;
+        return false;
+    }
+    if (SDL_RenderTargetSupported(renderer)) {
+        worldTarget = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, WIDTH, HEIGHT);
+    }
+    if (!worldTarget) {
+        std::cerr << "Dynamic resolution unavailable: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_SetTextureScaleMode(worldTarget, SDL_ScaleModeLinear);  // Smooth the upscale rather than show blocky pixels
+    return true;
+}
+
+// Fraction of the window's width and height the world is drawn at, from RESOLUTION_MIN_SCALE to 1
+void Renderer::setResolutionScale(float scale) {
+    resolutionScale = std::max(RESOLUTION_MIN_SCALE, std::min(scale, 1.0f));
+}
+
+// Stretch the part of worldTarget drawn this frame over the window
+void Renderer::upscaleWorld() {
+    SDL_SetRenderTarget(renderer, NULL);  // Also restores the window's scale of 1
+    SDL_Rect drawn = {0, 0, static_cast<int>(std::ceil(WIDTH * resolutionScale)), static_cast<int>(std::ceil(HEIGHT * resolutionScale))};
+    SDL_RenderCopy(renderer, worldTarget, &drawn, NULL);
+}
+
+// Convert the atlas regions our sprites use to ARGB with the ambient light multiplied in, the way the
+// sprite batch tints them, and drop chunk images lit the old way. The rest of each page stays empty.
+void Renderer::relightPages(const LightLevel& light) {
+    destroyMapChunks();  // Waits for chunk jobs still reading the old pages
+    chunksDirty = true;
+    pagesLight = &light;
+    litPages.assign(atlas ? atlas->pageCount() : 0, PixelImage());
+    std::vector<const AtlasSprite*> used = {&gearSprite};
+    for (const auto& sprite : recruitFrames) used.push_back(&sprite);
+    for (const auto& sprite : diFrames) used.push_back(&sprite);
+    for (const auto& sprite : structureSprites) used.push_back(&sprite);
+    for (const AtlasSprite* sprite : used) {
+        if (sprite->page < 0 || sprite->page >= static_cast<int>(litPages.size())) continue;
+        SDL_Surface* surface = atlas->pageSurface(sprite->page);
+        if (!surface) continue;
+        PixelImage& page = litPages[sprite->page];
+        if (page.pixels.empty()) page.resize(surface->w, surface->h);
+        SDL_Rect rect = sprite->src;
+        SDL_Rect whole = {0, 0, surface->w, surface->h};
+        if (!SDL_IntersectRect(&rect, &whole, &rect)) continue;
+        SDL_LockSurface(surface);
+        for (int y = rect.y; y < rect.y + rect.h; ++y) {
+            const Uint8* in = static_cast<const Uint8*>(surface->pixels) + y * surface->pitch + rect.x * 4;  // RGBA32: bytes R, G, B, A
+            Uint32* out = page.pixels.data() + static_cast<size_t>(y) * page.width + rect.x;
+            for (int x = 0; x < rect.w; ++x, in += 4) {
+                out[x] = packArgb(modulate({in[0], in[1], in[2], in[3]}, light.ambient));
             }
         }
+        SDL_UnlockSurface(surface);
     }
+}
 
-    // Draw recruit with animation
-    SDL_Rect srcRect = {recruitFrame * SPRITE_SIZE, 0, SPRITE_SIZE, SPRITE_SIZE};  // Assuming horizontal sprite sheet
-    SDL_Rect recruitRect = {static_cast<int>(recruitPos.x - cameraPos.x), static_cast<int>(recruitPos.y - cameraPos.y), SPRITE_SIZE, SPRITE_SIZE};
-    if (recruitRect.x + recruitRect.w > 0 && recruitRect.x < WIDTH && recruitRect.y + recruitRect.h > 0 && recruitRect.y < HEIGHT) {
-        SDL_RenderCopy(renderer, recruitTexture, &srcRect, &recruitRect);
+// Software blitter: draw the frame's world into the framebuffer and copy it to the renderer
+void Renderer::blitWorld(const SDL_Rect& view, const LightLevel& light, float stamina) {
+    void* pixels = nullptr;
+    int pitch = 0;
+    if (SDL_LockTexture(framebuffer, NULL, &pixels, &pitch) < 0) {
+        std::cerr << "Failed to lock the software framebuffer: " << SDL_GetError() << std::endl;
+        softSprites.clear();
+        return;
     }
+    PixelView target = {static_cast<Uint32*>(pixels), WIDTH, HEIGHT, pitch / 4};
 
-    // Draw DI (if not gear collected) with animation
-    if (!gearCollected) {
-        SDL_Rect diSrcRect = {diFrame * SPRITE_SIZE, 0, SPRITE_SIZE, SPRITE_SIZE};  // Assuming horizontal sprite sheet
-        SDL_Rect diRect = {static_cast<int>(diPos.x - cameraPos.x), static_cast<int>(diPos.y - cameraPos.y), SPRITE_SIZE, SPRITE_SIZE};
-        if (diRect.x + diRect.w > 0 && diRect.x < WIDTH && diRect.y + diRect.h > 0 && diRect.y < HEIGHT) {
-            SDL_RenderCopy(renderer, diTexture, &diSrcRect, &diRect);
+    // Ground shows only where no chunk covers the view: past the map edge, or a chunk not resident yet
+    int firstCol = std::max(0, view.x / MAP_CHUNK_SIZE);
+    int firstRow = std::max(0, view.y / MAP_CHUNK_SIZE);
+    int lastCol = std::min(chunkColumns - 1, (view.x + view.w - 1) / MAP_CHUNK_SIZE);
+    int lastRow = std::min(chunkRows - 1, (view.y + view.h - 1) / MAP_CHUNK_SIZE);
+    bool covered = chunksCached && view.x >= 0 && view.y >= 0 &&
+                   view.x + view.w <= chunkColumns * MAP_CHUNK_SIZE && view.y + view.h <= chunkRows * MAP_CHUNK_SIZE;
+    for (int row = firstRow; covered && row <= lastRow; ++row) {
+        for (int col = firstCol; covered && col <= lastCol; ++col) covered = mapChunks[row * chunkColumns + col].resident();
+    }
+    if (!covered) blitter.fill(target, {0, 0, WIDTH, HEIGHT}, packArgb(light.background));
+    for (int row = firstRow; chunksCached && row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) {
+            const MapChunk& chunk = mapChunks[row * chunkColumns + col];
+            if (!chunk.resident()) continue;
+            blitter.copy(target, chunk.bounds.x - view.x, chunk.bounds.y - view.y, chunk.image.view(), {0, 0, MAP_CHUNK_SIZE, MAP_CHUNK_SIZE});
         }
     }
 
-    // Draw gear (if not collected)
-    if (!gearCollected) {
-        SDL_Rect gearRect = {static_cast<int>(gearPos.x - cameraPos.x), static_cast<int>(gearPos.y - cameraPos.y), SPRITE_SIZE, SPRITE_SIZE};
-        if (gearRect.x + gearRect.w > 0 && gearRect.x < WIDTH && gearRect.y + gearRect.h > 0 && gearRect.y < HEIGHT) {
-            SDL_RenderCopy(renderer, gearTexture, NULL, &gearRect);
-        }
+    for (const SoftSprite& sprite : softSprites) {
+        if (sprite.page < static_cast<int>(litPages.size())) blitter.blendScaled(target, sprite.dst, litPages[sprite.page].view(), sprite.src);
+    }
+    softSprites.clear();
+
+    blitter.fill(target, {10, 10, 200, 20}, packArgb(BLACK));
+    blitter.fill(target, {10, 10, static_cast<int>((stamina / 100.0f) * 200), 20}, packArgb(GREEN));
+    Uint32 dust = packArgb(modulate(BROWN, light.ambient));
+    for (const SDL_Rect& rect : dustParticles.screenRects(cameraPos)) blitter.fill(target, rect, dust);
+
+    SDL_UnlockTexture(framebuffer);
+    SDL_RenderCopy(renderer, framebuffer, NULL, NULL);
+}
+
+void Renderer::drawBackground(const SDL_Rect& view, const LightLevel& light) {
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, background);
+    SDL_SetRenderDrawColor(renderer, light.background.r, light.background.g, light.background.b, 255);
+    SDL_RenderClear(renderer);
+    queueMap(view);
+    spriteBatch.flush(light.ambient);
+    SDL_SetRenderTarget(renderer, previousTarget);
+    backgroundView = view;
+    backgroundLight = &light;
+    backgroundValid = true;
+    fullRedraw = true;
+}
+
+// Copy the background over everything drawn this frame or the last, or over the whole screen if
+// that is most of it anyway
+void Renderer::repaintDamage() {
+    damage.clear();
+    damage.merge(drawnNow);
+    damage.merge(drawnBefore);
+    if (fullRedraw || damage.mostlyDirty()) {
+        fullRedraw = true;
+        SDL_RenderCopy(renderer, background, NULL, NULL);
+        return;
+    }
+    for (const SDL_Rect& rect : damage.rects()) SDL_RenderCopy(renderer, background, &rect, &rect);
+}
+
+// Show the frame; in dirty rectangle mode only the repainted tiles are copied to the window
+void Renderer::present() {
+    if (!windowSurface) {
+        SDL_RenderPresent(renderer);
+        return;
+    }
+    SDL_RenderFlush(renderer);  // Run the queued draws on the window surface before it is shown
+    if (fullRedraw || !dirtyRects) {
+        SDL_UpdateWindowSurface(window);
+    } else if (!damage.empty()) {
+        const std::vector<SDL_Rect>& rects = damage.rects();
+        SDL_UpdateWindowSurfaceRects(window, rects.data(), static_cast<int>(rects.size()));
+    }
+    std::swap(drawnNow, drawnBefore);
+    drawnNow.clear();
+    fullRedraw = false;
+}
+
+// dayNightCycle fixes the darkness (0 = day, 1 = night); negative follows the EST clock
+// Recruits, DIs and gear are drawn at the given positions; the caller leaves out collected gear, and the DIs once it's all in
+void Renderer::renderScene(const float* recruitX, const float* recruitY, const int* recruitFrame, int recruitCount, const float* diX, const float* diY, int diCount,
+                           const float* gearX, const float* gearY, int gearCount, float stamina, float dayNightCycle, int diFrame) {
+    const LightLevel& light = (dayNightCycle >= 0) ? lighting.at(dayNightCycle) : lighting.update(SDL_GetTicks());
+
+    // Draw Parris Island map (water, roads, buildings, obstacles, sand pits, etc.) from the chunk cache
+    if (softwareBlit && &light != pagesLight) relightPages(light);  // Chunk images have the light baked in
+    if (chunksDirty) resetMapChunks();
+    SDL_Rect view = {static_cast<int>(cameraPos.x), static_cast<int>(cameraPos.y), WIDTH, HEIGHT};
+    if (chunksCached) streamMapChunks(view);  // Before the world target is bound: chunk rendering switches targets
+    bool scaled = worldTarget && resolutionScale < 1.0f && !dirtyRects && !softwareBlit;
+    if (scaled) {
+        SDL_SetRenderTarget(renderer, worldTarget);
+        SDL_RenderSetScale(renderer, resolutionScale, resolutionScale);  // Everything below keeps window coordinates
+    }
+    if (dirtyRects) {
+        bool moved = view.x != backgroundView.x || view.y != backgroundView.y || &light != backgroundLight;
+        if (!backgroundValid || moved) drawBackground(view, light);  // Repainted from in repaintDamage()
+    } else if (!softwareBlit) {  // The blitter draws the ground and map in blitWorld()
+        SDL_SetRenderDrawColor(renderer, light.background.r, light.background.g, light.background.b, 255);
+        SDL_RenderClear(renderer);
+        queueMap(view);
+    }
+
+    // Draw recruits with animation
+    for (int i = 0; i < recruitCount; ++i) {
+        const AtlasSprite& recruitSprite = recruitFrames[recruitFrame[i] % RECRUIT_FRAMES];
+        SDL_Rect recruitRect = {static_cast<int>(recruitX[i] - cameraPos.x), static_cast<int>(recruitY[i] - cameraPos.y), SPRITE_SIZE, SPRITE_SIZE};
+        queueSprite(recruitSprite, recruitRect, LAYER_RECRUIT);
+    }
+
+    // Draw DIs with animation
+    const AtlasSprite& diSprite = diFrames[diFrame % DI_FRAMES];
+    for (int i = 0; i < diCount; ++i) {
+        SDL_Rect diRect = {static_cast<int>(diX[i] - cameraPos.x), static_cast<int>(diY[i] - cameraPos.y), SPRITE_SIZE, SPRITE_SIZE};
+        queueSprite(diSprite, diRect, LAYER_DRILL_INSTRUCTORS);
+    }
+
+    // Draw gear
+    for (int i = 0; i < gearCount; ++i) {
+        SDL_Rect gearRect = {static_cast<int>(gearX[i] - cameraPos.x), static_cast<int>(gearY[i] - cameraPos.y), SPRITE_SIZE, SPRITE_SIZE};
+        queueSprite(gearSprite, gearRect, LAYER_GEAR);
+    }
+
+    if (softwareBlit) {
+        blitWorld(view, light, stamina);
+        return;
+    }
+
+    if (scaled) {
+        spriteBatch.flush(light.ambient);
+        dustParticles.draw(renderer, cameraPos, modulate(BROWN, light.ambient));
+        upscaleWorld();
     }
 
     // Draw stamina bar (UI)
     SDL_Rect staminaOutline = {10, 10, 200, 20};
-    SDL_SetRenderDrawColor(renderer, BLACK.r, BLACK.g, BLACK.b, BLACK.a);
-    SDL_RenderFillRect(renderer, &staminaOutline);
+    spriteBatch.addRect(staminaOutline, BLACK, LAYER_HUD);
     SDL_Rect staminaFill = {10, 10, static_cast<int>((stamina / 100.0f) * 200), 20};
-    SDL_SetRenderDrawColor(renderer, GREEN.r, GREEN.g, GREEN.b, GREEN.a);
-    SDL_RenderFillRect(renderer, &staminaFill);
-
-    // Weather (dust storm if weatherTimer > 0)
-    if (weatherTimer > 0) {
-        weatherTimer--;
-        if (random() % 5 == 0) {
-            addParticle(Vector2(random() % WIDTH + cameraPos.x, random() % HEIGHT + cameraPos.y));
-        }
-    }
-
-    // Update and draw dust particles
-    for (auto it = dustParticles.begin(); it != dustParticles.end();) {
-        it->y += 1;
-        if (it->y > cameraPos.y + HEIGHT || it->x < cameraPos.x || it->x > cameraPos.x + WIDTH) {
-            it = dustParticles.erase(it);
-        } else {
-            SDL_Rect particleRect = {static_cast<int>(it->x - cameraPos.x), static_cast<int>(it->y - cameraPos.y), 8, 8};
-            SDL_SetRenderDrawColor(renderer, BROWN.r, BROWN.g, BROWN.b, BROWN.a);
-            SDL_RenderFillRect(renderer, &particleRect);
-            ++it;
-        }
+    spriteBatch.addRect(staminaFill, GREEN, LAYER_HUD);
+    if (dirtyRects) {
+        markDirty(staminaOutline);
+        for (const SDL_Rect& rect : dustParticles.screenRects(cameraPos)) drawnNow.add(rect);
+        repaintDamage();  // Before anything of this frame is drawn on screen
     }
+    spriteBatch.flush(light.ambient);  // Map and sprites lit, stamina bar not
+    if (scaled) return;
 
-    SDL_RenderPresent(renderer);
+    // Dust particles (already updated for this frame by the game)
+    dustParticles.draw(renderer, cameraPos, modulate(BROWN, light.ambient));
 }
@@ -2,52 +2,123 @@
 #define RENDERING_H
 
 #include "common.h"
+#include "lighting.h"
+#include "dirty_region.h"
+#include "soft_blitter.h"
+#include "resolution_scaler.h"
+#include "world_map.h"
+#include "particle_system.h"
+#include "sprite_batch.h"
+#include "texture_atlas.h"
+#include "job_system.h"
+#include <deque>
+#include <memory>
 #include <vector>
 
+// A fixed-size piece of the static map, pre-rendered into a target texture while it is near the camera
+struct MapChunk {
+    SDL_Rect bounds;                 // Area of the map covered by this chunk (map coordinates)
+    SDL_Texture* texture = nullptr;  // Cached structures for this area (transparent where there is only ground), null when evicted
+    PixelImage image;                // Software blitter: the chunk over lit ground instead, empty when evicted
+    Uint32 lastWanted = 0;           // Frame the chunk was last near the view, for LRU eviction
+    bool preparing = false;          // A job is collecting its quads
+
+    bool resident() const { return texture || !image.pixels.empty(); }
+};
+
+// Structure quads of one chunk, collected off the render thread (and rasterized there for the software blitter)
+struct ChunkJob {
+    int chunk;
+    std::vector<SpriteQuad> quads;
+    PixelImage image;
+    JobCounter counter;
+};
+
+// A sprite waiting for the software blitter
+struct SoftSprite {
+    int page;
+    SDL_Rect src, dst;
+};
+
 class Renderer {
 private:
     SDL_Renderer* renderer;
     SDL_Window* window;
-    std::vector<SDL_Rect> mapTiles;
-    std::vector<SDL_Rect> barracks;
-    std::vector<SDL_Rect> obstacleCourses;
-    std::vector<SDL_Rect> sandPits;
-    std::vector<SDL_Rect> roads;
-    std::vector<SDL_Rect> rifleRanges;
-    std::vector<SDL_Rect> paradeDecks;
-    std::vector<SDL_Rect> chowHalls;
-    std::vector<SDL_Rect> waterAreas;
-    SDL_Texture* recruitTexture;
-    SDL_Texture* diTexture;
-    SDL_Texture* gearTexture;
-    SDL_Texture* barrackTexture;      // Texture for barracks (brick with windows)
-    SDL_Texture* roadTexture;        // Texture for roads (pavement)
-    SDL_Texture* obstacleTexture;    // Texture for obstacles (wooden walls or training equipment)
-    SDL_Texture* sandPitTexture;     // Texture for sand pits (detailed sand pattern)
-    SDL_Texture* rifleRangeTexture;  // Texture for rifle ranges (tall grass or target range)
-    SDL_Texture* paradeDeckTexture;  // Texture for parade decks (smooth pavement or concrete)
-    SDL_Texture* chowHallTexture;    // Texture for chow halls (brick or building facade)
-    SDL_Texture* waterTexture;       // Texture for water areas (ocean or river)
+    const WorldMap* world = nullptr;  // Shared with the game, not owned
+    const TextureAtlas* atlas = nullptr;  // Source of the software blitter's pages, not owned
+    JobSystem* jobs = nullptr;        // Prepares map chunks in the background when set, not owned
+    AtlasSprite recruitFrames[RECRUIT_FRAMES];
+    AtlasSprite diFrames[DI_FRAMES];
+    AtlasSprite gearSprite;
+    AtlasSprite structureSprites[CATEGORY_COUNT];  // Per StructureCategory, no texture falls back to a flat color
     Vector2 cameraPos;
-    std::vector<Vector2> dustParticles;
+    ParticleSystem dustParticles;  // Updated by the game, drawn here
+    SpriteBatch spriteBatch;       // Map, sprites and stamina bar are queued here and drawn per (layer, texture)
+    Lighting lighting;
+    std::vector<MapChunk> mapChunks;  // Every chunk of the map, at most MAP_CHUNK_BUDGET of them resident
+    std::vector<int> residentChunks;
+    std::deque<std::unique_ptr<ChunkJob>> chunkJobs;
+    std::vector<SpriteQuad> mapQuads;  // Scratch for chunks prepared on this thread
+    int chunkColumns = 0, chunkRows = 0;
+    Uint32 chunkFrame = 0;
+    bool chunksDirty = true;  // Set whenever map data or textures change, cleared by resetMapChunks()
+    bool chunksCached = false;  // False if render targets are unavailable and the map is drawn directly
+    bool windowSurface = false;           // The renderer draws into the window surface, see setDirtyRects()
+    bool dirtyRects = false;              // Partial redraw mode
+    SDL_Texture* background = nullptr;    // Ground and map as seen from backgroundView, what dirty tiles are repainted from
+    SDL_Rect backgroundView = {0, 0, 0, 0};
+    const LightLevel* backgroundLight = nullptr;
+    bool backgroundValid = false;
+    bool fullRedraw = true;               // This frame repaints and presents the whole screen
+    DirtyRegion drawnNow, drawnBefore;    // Tiles covered by sprites, dust and HUD this frame and the last
+    DirtyRegion damage;                   // What this frame repaints and presents
+    bool softwareBlit = false;            // World composed by the SoftBlitter, see setSoftwareBlit()
+    SoftBlitter blitter;
+    SDL_Texture* framebuffer = nullptr;   // Streaming texture the world is blitted into
+    std::vector<PixelImage> litPages;     // Atlas pages as ARGB with the ambient light baked into the sprites in use
+    const LightLevel* pagesLight = nullptr;  // What litPages and the chunk images were lit with
+    std::vector<SoftSprite> softSprites;
+    SDL_Texture* worldTarget = nullptr;   // Dynamic resolution: the world is drawn into its top-left corner, then upscaled
+    float resolutionScale = 1.0f;
+
+    void resetMapChunks();
+    void destroyMapChunks();
+    void streamMapChunks(const SDL_Rect& view);
+    void prepareChunk(int index);
+    bool renderChunk(int index, const std::vector<SpriteQuad>& quads);
+    SDL_Texture* acquireChunkTexture();
+    int leastRecentlyWanted() const;
+    bool storeChunkImage(int index, PixelImage& image);
+    void rasterizeChunk(const std::vector<SpriteQuad>& quads, PixelImage& image) const;
+    int pageOf(SDL_Texture* texture) const;
+    void relightPages(const LightLevel& light);
+    void blitWorld(const SDL_Rect& view, const LightLevel& light, float stamina);
+    void upscaleWorld();
+    void collectMapQuads(const SDL_Rect& view, std::vector<SpriteQuad>& quads) const;
+    void drawMapLayer(const SDL_Rect& view);
+    void queueMap(const SDL_Rect& view);
+    void queueSprite(const AtlasSprite& sprite, const SDL_Rect& dst, int layer);
+    void drawBackground(const SDL_Rect& view, const LightLevel& light);
+    void repaintDamage();
 
 public:
     Renderer(SDL_Window* win, SDL_Renderer* rend);
     ~Renderer();
-    void initializeMap(const std::vector<SDL_Rect>& tiles, const std::vector<SDL_Rect>& buildings,
-                       const std::vector<SDL_Rect>& obstacles, const std::vector<SDL_Rect>& pits,
-                       const std::vector<SDL_Rect>& roadTiles, const std::vector<SDL_Rect>& ranges,
-                       const std::vector<SDL_Rect>& decks, const std::vector<SDL_Rect>& chows,
-                       const std::vector<SDL_Rect>& waters);
-    void setTextures(SDL_Texture* recruit, SDL_Texture* di, SDL_Texture* gear,
-                     SDL_Texture* barrack = nullptr, SDL_Texture* road = nullptr, SDL_Texture* obstacle = nullptr,
-                     SDL_Texture* sandPit = nullptr, SDL_Texture* rifleRange = nullptr, SDL_Texture* paradeDeck = nullptr,
-                     SDL_Texture* chowHall = nullptr, SDL_Texture* water = nullptr);
-    void renderScene(Vector2 recruitPos, Vector2 diPos, Vector2 gearPos, bool gearCollected, float stamina, int catchCount, int frameCount, int weatherTimer, float dayNightCycle, int recruitFrame, int diFrame);
+    void initializeMap(const WorldMap* map);
+    void setJobSystem(JobSystem* jobSystem) { jobs = jobSystem; }
+    bool setDirtyRects(bool enabled);
+    bool setSoftwareBlit(bool enabled);
+    bool setDynamicResolution(bool enabled);
+    void setResolutionScale(float scale);
+    float getResolutionScale() const { return worldTarget ? resolutionScale : 1.0f; }
+    void markDirty(const SDL_Rect& rect) { if (dirtyRects) drawnNow.add(rect); }  // Drawn over the scene this frame (HUD text, overlays)
+    void present();
+    void setSprites(const TextureAtlas& atlas);
+    void renderScene(const float* recruitX, const float* recruitY, const int* recruitFrame, int recruitCount, const float* diX, const float* diY, int diCount,
+                     const float* gearX, const float* gearY, int gearCount, float stamina, float dayNightCycle, int diFrame);
     void addParticle(Vector2 pos);
     void setCamera(Vector2 pos);
-    std::vector<Vector2>& getDustParticles();
-    float getDayNightFactor();
+    ParticleSystem& getDustParticles();
 };
 
 #endif // RENDERING_H
@@ -0,0 +1,31 @@
+#include "resolution_scaler.h"
+#include <algorithm>
+#include <cmath>
+
+float ResolutionScaler::update(float frameMs) {
+    averageMs = averageMs > 0.0f ? averageMs + (frameMs - averageMs) * RESOLUTION_SMOOTHING : frameMs;
+    if (settleFrames > 0) settleFrames--;
+
+    if (averageMs > budgetMs) {
+        framesWithHeadroom = 0;
+        framesWithinBudget = 0;
+        if (settleFrames > 0 || scale <= RESOLUTION_MIN_SCALE) return scale;
+        float fit = scale * std::sqrt(budgetMs / averageMs);  // Frame time taken as proportional to the pixels drawn
+        fit = std::floor(fit / RESOLUTION_STEP) * RESOLUTION_STEP;
+        scale = std::max(RESOLUTION_MIN_SCALE, std::min(fit, scale - RESOLUTION_STEP));
+        averageMs = budgetMs;  // Assume the drop fits until new frames say otherwise
+        settleFrames = RESOLUTION_SETTLE_FRAMES;
+        return scale;
+    }
+
+    // A step up that overshoots is dropped again above and has to wait out the counters once more
+    framesWithinBudget++;
+    framesWithHeadroom = averageMs <= budgetMs * RESOLUTION_HEADROOM ? framesWithHeadroom + 1 : 0;
+    if (scale < 1.0f && (framesWithHeadroom >= RESOLUTION_RAISE_FRAMES || framesWithinBudget >= RESOLUTION_PROBE_FRAMES)) {
+        scale = std::min(1.0f, scale + RESOLUTION_STEP);
+        framesWithHeadroom = 0;
+        framesWithinBudget = 0;
+        settleFrames = RESOLUTION_SETTLE_FRAMES;
+    }
+    return scale;
+}
@@ -0,0 +1,33 @@
+#ifndef RESOLUTION_SCALER_H
+#define RESOLUTION_SCALER_H
+
+#include "common.h"
+
+const float RESOLUTION_MIN_SCALE = 0.5f;     // Below this the world gets too blurry to read
+const float RESOLUTION_STEP = 0.0625f;       // Scales are kept on 1/16 steps so the target size doesn't jitter
+const float RESOLUTION_SMOOTHING = 0.2f;     // Weight of the newest frame in the smoothed frame time
+const float RESOLUTION_HEADROOM = 0.85f;     // Frames this far under budget are cheap enough to try a step up
+const int RESOLUTION_RAISE_FRAMES = 60;      // Frames with headroom before stepping up
+const int RESOLUTION_PROBE_FRAMES = 240;     // Frames merely within budget, without headroom, before trying a step up
+const int RESOLUTION_SETTLE_FRAMES = 10;     // Frames after a change before the next drop, so it shows in the average
+
+// Picks the world's render scale from measured frame times to hold a frame-time budget. Over budget
+// it drops at once, by the scale that would fit if time were proportional to the pixel count; under
+// budget it climbs back one step at a time, so a brief spike doesn't make the picture pump.
+class ResolutionScaler {
+private:
+    float budgetMs;
+    float scale = 1.0f;
+    float averageMs = 0.0f;
+    int framesWithHeadroom = 0;
+    int framesWithinBudget = 0;
+    int settleFrames = 0;
+
+public:
+    explicit ResolutionScaler(float budget = 1000.0f / 60) : budgetMs(budget) {}
+    void setBudget(float budget) { budgetMs = budget; }
+    float update(float frameMs);  // Feed the last frame's time, get the scale for the next one
+    float getScale() const { return scale; }
+};
+
+#endif // RESOLUTION_SCALER_H
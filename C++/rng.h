@@ -0,0 +1,37 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include "common.h"
+
+// PCG32 (permuted congruential generator): 8 bytes of state, a few cycles per number and the same
+// sequence on every platform for the same seed, so a seeded simulation replays bit for bit.
+class Rng {
+private:
+    Uint64 state = 0;
+    Uint64 increment;
+
+public:
+    explicit Rng(Uint64 seed = 0x853c49e6748fea9bULL, Uint64 stream = 0xda3e39cb94b95bdbULL) : increment((stream << 1) | 1) {
+        next();
+        state += seed;
+        next();
+    }
+
+    Uint32 next() {
+        Uint64 old = state;
+        state = old * 6364136223846793005ULL + increment;
+        Uint32 xorShifted = static_cast<Uint32>(((old >> 18) ^ old) >> 27);
+        Uint32 rotation = static_cast<Uint32>(old >> 59);
+        return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+    }
+
+    // Uniform integer in [0, n) for n > 0
+    int below(int n) { return static_cast<int>((static_cast<Uint64>(next()) * static_cast<Uint64>(n)) >> 32); }
+
+    // Uniform float in [0, 1)
+    float chance() { return (next() >> 8) * (1.0f / 16777216.0f); }
+
+    Uint64 getState() const { return state; }
+};
+
+#endif // RNG_H
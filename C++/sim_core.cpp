@@ -0,0 +1,404 @@
+#include "sim_core.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Build the collision grid and flow field for map, then place the platoon, the gear and the DIs from seed
+bool SimCore::init(const WorldMap* map, int drillInstructorCount, Uint64 seed, int recruitCount, int objectiveCount) {
+    if (!map || !map->isLoaded()) return false;
+    world = map;
+    rng = Rng(seed);
+    current = SimState();
+    tickEvents.clear();
+
+    collisionGrid.clear();
+    for (int i = 0; i < CATEGORY_COUNT; ++i) {
+        collisionGrid.add(world->rects(static_cast<StructureCategory>(i)), static_cast<StructureCategory>(i));
+    }
+    collisionGrid.build(world->width(), world->height());
+    pursuitField.build(collisionGrid, world->width(), world->height());
+    diGrid.resize(world->width(), world->height());
+    pickupGrid.resize(world->width(), world->height());
+
+    // Recruit 0 starts near the west road, the rest of the platoon falls in behind in ranks on open ground
+    RecruitPlatoon& recruits = current.recruits;
+    const Vector2 start(400, 250);
+    recruits.add(start, maxStamina);
+    for (int slot = 1; recruits.size() < recruitCount && slot < recruitCount * 4; ++slot) {
+        Vector2 pos(start.x + (slot % PLATOON_COLUMNS) * SPRITE_SIZE, start.y + (slot / PLATOON_COLUMNS) * SPRITE_SIZE);
+        if (pos.x <= world->width() - SPRITE_SIZE && pos.y <= world->height() - SPRITE_SIZE && !isBlocked(pos, nearbyStructures)) {
+            recruits.add(pos, maxStamina);
+        }
+    }
+
+    PickupSet& objectives = current.objectives;
+    while (objectives.size() < std::max(1, objectiveCount)) {
+        objectives.add(Vector2(rng.below(world->width() - 200) + 100, rng.below(world->height() - 200) + 100));
+    }
+    pickupGrid.rebuild(objectives.xs(), objectives.ys(), objectives.size());
+
+    // First DI starts near the east road, any extra ones anywhere on open ground. A map with little
+    // open ground gets fewer DIs rather than an endless search
+    DrillInstructorSwarm& drillInstructors = current.drillInstructors;
+    drillInstructors.setCooldown(drillInstructors.add(Vector2(1200, 500)), CATCH_COOLDOWN);
+    const long long maxAttempts = static_cast<long long>(drillInstructorCount) * DI_SPAWN_ATTEMPTS;
+    for (long long attempt = 0; drillInstructors.size() < drillInstructorCount && attempt < maxAttempts; ++attempt) {
+        Vector2 spawn(rng.below(world->width() - SPRITE_SIZE), rng.below(world->height() - SPRITE_SIZE));
+        if (!isBlocked(spawn, nearbyStructures)) drillInstructors.setCooldown(drillInstructors.add(spawn), CATCH_COOLDOWN);
+    }
+    if (drillInstructors.size() < drillInstructorCount) {
+        std::cerr << "Only found open ground for " << drillInstructors.size() << " of " << drillInstructorCount << " DIs" << std::endl;
+    }
+    return true;
+}
+
+Vector2 SimCore::slideAroundObstacle(Vector2 pos, Vector2 step, Vector2 target, const SDL_Rect& obstacle) const {
+    SDL_Rect newRect = {static_cast<int>(target.x), static_cast<int>(target.y), SPRITE_SIZE, SPRITE_SIZE};
+    if (SDL_HasIntersection(&newRect, &obstacle)) {
+        Vector2 slidePos(pos.x + step.x, pos.y);
+        newRect = {static_cast<int>(slidePos.x), static_cast<int>(slidePos.y), SPRITE_SIZE, SPRITE_SIZE};
+        if (!SDL_HasIntersection(&newRect, &obstacle)) return slidePos;
+        slidePos = Vector2(pos.x, pos.y + step.y);
+        newRect = {static_cast<int>(slidePos.x), static_cast<int>(slidePos.y), SPRITE_SIZE, SPRITE_SIZE};
+        if (!SDL_HasIntersection(&newRect, &obstacle)) return slidePos;
+        return pos;  // Stay in place if still stuck
+    }
+    return target;
+}
+
+// Move a sprite by step, resolving collisions against the structures near it only.
+// Barracks, obstacles and chow halls are slid around, rifle ranges and parade decks block,
+// sand pits halve the speed. Returns the number of sand pits the sprite ended up in.
+int SimCore::moveThroughStructures(Vector2& pos, Vector2 step, std::vector<int>& nearby) const {
+    Vector2 newPos(pos.x + step.x, pos.y + step.y);
+    int reach = static_cast<int>(std::ceil(std::max(std::fabs(step.x), std::fabs(step.y)))) + 1;
+    SDL_Rect area = {static_cast<int>(pos.x) - reach, static_cast<int>(pos.y) - reach, SPRITE_SIZE + 2 * reach, SPRITE_SIZE + 2 * reach};
+    const Uint32 solidMask = categoryBit(CATEGORY_BARRACKS) | categoryBit(CATEGORY_OBSTACLE) | categoryBit(CATEGORY_SAND_PIT) |
+                             categoryBit(CATEGORY_RIFLE_RANGE) | categoryBit(CATEGORY_PARADE_DECK) | categoryBit(CATEGORY_CHOW_HALL);
+    collisionGrid.query(area, solidMask, nearby);
+
+    int sandPitCount = 0;
+    for (int index : nearby) {
+        const GridEntry& structure = collisionGrid.entry(index);
+        SDL_Rect spriteRect = {static_cast<int>(newPos.x), static_cast<int>(newPos.y), SPRITE_SIZE, SPRITE_SIZE};
+        switch (structure.category) {
+        case CATEGORY_BARRACKS:
+        case CATEGORY_OBSTACLE:
+        case CATEGORY_CHOW_HALL:
+            newPos = slideAroundObstacle(pos, step, newPos, structure.rect);
+            break;
+        case CATEGORY_SAND_PIT:
+            if (SDL_HasIntersection(&spriteRect, &structure.rect)) {
+                sandPitCount++;
+                newPos = Vector2(pos.x + step.x / 2.0f, pos.y + step.y / 2.0f);  // Halve the speed in sand pits
+            }
+            break;
+        default:  // Rifle ranges and parade decks
+            if (SDL_HasIntersection(&spriteRect, &structure.rect)) newPos = pos;
+            break;
+        }
+    }
+    pos = newPos;
+    return sandPitCount;
+}
+
+// Keep a sprite on the ground: anything in a building's column and above its base is pushed below it
+void SimCore::stayOnGround(Vector2& pos, std::vector<int>& nearby) const {
+    SDL_Rect column = {static_cast<int>(pos.x) - 1, 0, 3, world->height()};
+    collisionGrid.query(column, categoryBit(CATEGORY_BARRACKS) | categoryBit(CATEGORY_CHOW_HALL), nearby);
+    for (int index : nearby) {
+        const SDL_Rect& building = collisionGrid.entry(index).rect;
+        if (pos.x >= building.x && pos.x <= building.x + building.w && pos.y < building.y + building.h) {
+            pos.y = building.y + building.h;  // Push to ground level below building
+        }
+    }
+}
+
+// True if a sprite at pos would overlap anything that blocks movement
+bool SimCore::isBlocked(Vector2 pos, std::vector<int>& nearby) const {
+    SDL_Rect spriteRect = {static_cast<int>(pos.x), static_cast<int>(pos.y), SPRITE_SIZE, SPRITE_SIZE};
+    collisionGrid.query(spriteRect, ~categoryBit(CATEGORY_ROAD) & ~categoryBit(CATEGORY_WATER) & ~categoryBit(CATEGORY_SAND_PIT), nearby);
+    for (int index : nearby) {
+        if (SDL_HasIntersection(&spriteRect, &collisionGrid.entry(index).rect)) return true;
+    }
+    return false;
+}
+
+// Movement system, for every archetype with MoverArrays: each entity in [begin, end) that isn't held
+// takes its step through the structures, stays on the ground and on the map. Entities only read
+// the static collision grid and write their own components, so ranges can run on different threads.
+// Sand pits entered are written to sandPits when given.
+void SimCore::moveSystem(const MoverArrays& movers, int begin, int end, int* sandPits, std::vector<int>& nearby) const {
+    for (int i = begin; i < end; ++i) {
+        if (movers.held[i]) continue;
+        Vector2 pos(movers.x[i], movers.y[i]);
+        int pits = moveThroughStructures(pos, Vector2(movers.vx[i], movers.vy[i]), nearby);
+        if (sandPits) sandPits[i] = pits;
+        stayOnGround(pos, nearby);  // Ensure the sprite stays on ground (not above buildings)
+
+        // Keep it on the map
+        pos.x = std::max(0.0f, std::min(pos.x, static_cast<float>(world->width() - SPRITE_SIZE)));
+        pos.y = std::max(0.0f, std::min(pos.y, static_cast<float>(world->height() - SPRITE_SIZE)));
+        movers.x[i] = pos.x;
+        movers.y[i] = pos.y;
+    }
+}
+
+// Run the movement system over a whole archetype, split across the job system when there is one
+void SimCore::moveAll(const MoverArrays& movers, int grain, int* sandPits) {
+    auto moveRange = [this, &movers, sandPits](int begin, int end) {
+        static thread_local std::vector<int> nearby;  // Collision query scratch, one per thread
+        moveSystem(movers, begin, end, sandPits, nearby);
+    };
+    if (jobs) jobs->parallelFor(movers.count, grain, moveRange);
+    else moveRange(0, movers.count);
+}
+
+// Let go of a recruit: its DI backs off and cannot catch again until its cooldown runs out
+void SimCore::releaseRecruit(int recruit) {
+    RecruitPlatoon& recruits = current.recruits;
+    int di = recruits.holder(recruit);
+    if (di >= 0) {
+        DrillInstructorSwarm& drillInstructors = current.drillInstructors;
+        Vector2 diPos = drillInstructors.position(di);
+        drillInstructors.setPosition(di, Vector2(diPos.x + rng.below(200) - 100, diPos.y + rng.below(200) - 100));  // DI backs off further
+        drillInstructors.setLatched(di, false);
+        drillInstructors.setCooldown(di, CATCH_COOLDOWN);
+    }
+    recruits.release(recruit);
+}
+
+// Escape system: every held recruit tries to break free when escape is pressed
+void SimCore::escapeSystem(const SimInput& input) {
+    RecruitPlatoon& recruits = current.recruits;
+    if (!input.escape || recruits.heldCount() == 0) return;
+    for (int i = 0; i < recruits.size(); ++i) {
+        if (!recruits.isHeld(i)) continue;
+        float escapeChance = std::min(0.9f, recruits.getStamina(i) / maxStamina);  // Cap at 90% chance, even at full stamina
+        if (rng.chance() < escapeChance) {
+            releaseRecruit(i);
+            tickEvents.push_back({SIM_EVENT_ESCAPED, i});
+        } else {
+            recruits.setStamina(i, recruits.getStamina(i) - 15.0f);  // Increase stamina cost for failed escape
+            tickEvents.push_back({SIM_EVENT_ESCAPE_FAILED, i});
+        }
+    }
+}
+
+// Stamina system: sprinting drains it and walking restores it, for free recruits; sets each one's step
+void SimCore::staminaSystem(const SimInput& input, Vector2 direction) {
+    RecruitPlatoon& recruits = current.recruits;
+    for (int i = 0; i < recruits.size(); ++i) {
+        float stamina = recruits.getStamina(i);
+        bool free = !recruits.isHeld(i);
+        bool sprinting = input.sprint && stamina > 0 && free;
+        float speed = sprinting ? sprintSpeed : recruitSpeed;
+        if (sprinting) stamina -= staminaDrain;
+        else if (stamina < maxStamina && free) stamina += staminaRegen;
+        recruits.setStamina(i, std::max(0.0f, std::min(stamina, maxStamina)));
+        recruits.setVelocity(i, Vector2(direction.x * speed, direction.y * speed));
+    }
+}
+
+// Holding: a held recruit drags its DI along until the latch times out (sooner when exhausted)
+void SimCore::holdSystem() {
+    RecruitPlatoon& recruits = current.recruits;
+    DrillInstructorSwarm& drillInstructors = current.drillInstructors;
+    for (int i = 0; i < recruits.size() && recruits.heldCount() > 0; ++i) {
+        if (!recruits.isHeld(i)) continue;
+        int ticks = recruits.tickLatch(i);
+        drillInstructors.setPosition(recruits.holder(i), recruits.position(i));  // DI stays on the recruit while latched
+        if (ticks >= LATCH_DURATION || (recruits.getStamina(i) <= 0 && ticks >= LATCH_DURATION / 2)) {  // Automatic escape if timed out or low stamina
+            releaseRecruit(i);
+            tickEvents.push_back({SIM_EVENT_AUTO_ESCAPED, i});
+        }
+    }
+}
+
+// Pursuit: every free DI follows the shared flow field toward the nearest free recruit, or heads
+// straight for the closest one where the field has no heading (same cell, unreachable). Once the
+// whole platoon is held the DIs close in on it all the same. Steps are computed swarm-wide.
+void SimCore::pursuitSystem() {
+    SimState& s = current;
+    const RecruitPlatoon& recruits = s.recruits;
+    DrillInstructorSwarm& drillInstructors = s.drillInstructors;
+    const float halfSprite = SPRITE_SIZE / 2.0f;
+    pursued.clear();
+    pursuedCenters.clear();
+    bool anyFree = recruits.heldCount() < recruits.size();
+    for (int i = 0; i < recruits.size(); ++i) {
+        if (anyFree && recruits.isHeld(i)) continue;
+        Vector2 pos = recruits.position(i);
+        pursued.push_back(i);
+        pursuedCenters.push_back(Vector2(pos.x + halfSprite, pos.y + halfSprite));
+    }
+    pursuitField.update(pursuedCenters.data(), static_cast<int>(pursuedCenters.size()));
+    for (int i = 0; i < drillInstructors.size(); ++i) {
+        Vector2 diPos = drillInstructors.position(i), heading;
+        if (pursuitField.sample(Vector2(diPos.x + halfSprite, diPos.y + halfSprite), &heading)) {
+            drillInstructors.setHeading(i, heading);
+        } else {
+            Vector2 closest = recruits.position(pursued[0]);
+            float closestD2 = (closest.x - diPos.x) * (closest.x - diPos.x) + (closest.y - diPos.y) * (closest.y - diPos.y);
+            for (size_t p = 1; p < pursued.size(); ++p) {
+                Vector2 pos = recruits.position(pursued[p]);
+                float d2 = (pos.x - diPos.x) * (pos.x - diPos.x) + (pos.y - diPos.y) * (pos.y - diPos.y);
+                if (d2 < closestD2) {
+                    closest = pos;
+                    closestD2 = d2;
+                }
+            }
+            drillInstructors.setHeading(i, Vector2(closest.x - diPos.x, closest.y - diPos.y));
+        }
+    }
+    drillInstructors.computeChase(diSpeed);
+    moveAll(drillInstructors.movers(), DI_JOB_GRAIN, nullptr);
+    drillInstructors.tickCooldowns();
+    diGrid.rebuild(drillInstructors.xs(), drillInstructors.ys(), drillInstructors.size());
+}
+
+// Catching: the lowest-numbered DI in reach that may catch latches onto each free recruit
+void SimCore::catchSystem() {
+    SimState& s = current;
+    RecruitPlatoon& recruits = s.recruits;
+    DrillInstructorSwarm& drillInstructors = s.drillInstructors;
+    for (int i = 0; i < recruits.size() && !s.gameOver; ++i) {
+        if (recruits.isHeld(i)) continue;
+        int catcher = diGrid.lowestWithin(recruits.position(i), CATCH_RADIUS, [&drillInstructors](int di) { return drillInstructors.canCatch(di); });
+        if (catcher < 0) continue;
+        recruits.hold(i, catcher);
+        drillInstructors.setLatched(catcher, true);
+        s.catchCount++;  // Increment catch count only once per latch
+        tickEvents.push_back({SIM_EVENT_CAUGHT, s.catchCount});
+        if (s.catchCount >= MAX_CATCHES) {
+            s.gameOver = true;
+            tickEvents.push_back({SIM_EVENT_GAME_OVER, s.catchCount});
+        }
+    }
+}
+
+// Pickup: recruits collect the objectives they reach; the last one secures the gear and frees everyone
+void SimCore::pickupSystem() {
+    SimState& s = current;
+    PickupSet& objectives = s.objectives;
+    const RecruitPlatoon& recruits = s.recruits;
+    int before = objectives.remainingCount();
+    for (int i = 0; i < recruits.size(); ++i) {
+        pickupGrid.forEachWithin(recruits.position(i), PICKUP_RADIUS, [&objectives](int pickup, float) { objectives.collect(pickup); });
+    }
+    if (objectives.remainingCount() == before) return;
+    if (objectives.remainingCount() > 0) {
+        tickEvents.push_back({SIM_EVENT_OBJECTIVE_COLLECTED, objectives.remainingCount()});
+        return;
+    }
+    s.gearCollected = true;
+    tickEvents.push_back({SIM_EVENT_GEAR_COLLECTED, 0});
+    for (int i = 0; i < recruits.size() && recruits.heldCount() > 0; ++i) {
+        if (recruits.isHeld(i)) releaseRecruit(i);
+    }
+}
+
+// Animation: free recruits take a step of their walk cycle every 10th tick while moving, DIs yell
+// every 15th while nobody is held
+void SimCore::animationSystem(Vector2 direction) {
+    SimState& s = current;
+    RecruitPlatoon& recruits = s.recruits;
+    if ((direction.x != 0 || direction.y != 0) && s.tick % 10 == 0) {
+        int stepping = 0;
+        for (int i = 0; i < recruits.size(); ++i) {
+            if (recruits.isHeld(i)) continue;
+            recruits.advanceFrame(i, RECRUIT_FRAMES);
+            stepping++;
+        }
+        if (stepping > 0) tickEvents.push_back({SIM_EVENT_FOOTSTEP, stepping});
+    }
+    if (!s.gearCollected && s.tick % 15 == 0 && recruits.heldCount() == 0) s.diFrame = (s.diFrame + 1) % DI_FRAMES;
+}
+
+// Advance the simulation by one fixed tick
+void SimCore::step(const SimInput& input) {
+    tickEvents.clear();
+    SimState& s = current;
+    if (s.gameOver) return;
+
+    escapeSystem(input);
+
+    Vector2 direction(static_cast<float>(input.moveX), static_cast<float>(input.moveY));
+    if (direction.x != 0 || direction.y != 0) {
+        float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+        if (length != 0) { direction.x /= length; direction.y /= length; }
+    }
+    staminaSystem(input, direction);
+
+    // Move the free recruits; sand pits cost stamina on top of the pace
+    {
+        ProfileScope scope(profiler, PHASE_RECRUIT);
+        RecruitPlatoon& recruits = s.recruits;
+        std::fill(recruits.sandPitCounts(), recruits.sandPitCounts() + recruits.size(), 0);
+        moveAll(recruits.movers(), RECRUIT_JOB_GRAIN, recruits.sandPitCounts());
+        for (int i = 0; i < recruits.size(); ++i) {
+            if (recruits.sandPitsEntered(i) > 0) recruits.setStamina(i, recruits.getStamina(i) - staminaDrain * recruits.sandPitsEntered(i));
+        }
+    }
+
+    // DIs chase until the gear is secured
+    if (!s.gearCollected) {
+        {
+            ProfileScope scope(profiler, PHASE_DI_AI);
+            holdSystem();
+            pursuitSystem();
+            catchSystem();
+        }
+        if (s.gameOver) return;
+        pickupSystem();
+    }
+
+    animationSystem(direction);
+
+    if (s.tick % 600 == 0) s.weatherTimer = 120;
+    s.storming = s.weatherTimer > 0;
+    if (s.storming) s.weatherTimer--;
+    s.diNearby = false;
+    for (int i = 0; i < s.recruits.size() && !s.gearCollected && !s.diNearby; ++i) {
+        s.diNearby = !s.recruits.isHeld(i) && diGrid.anyWithin(s.recruits.position(i), TAUNT_RADIUS);
+    }
+
+    s.tick++;
+}
+
+static void hashBytes(Uint64& hash, const void* data, size_t size) {
+    const Uint8* bytes = static_cast<const Uint8*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;  // FNV-1a
+    }
+}
+
+// Hash of the whole simulation state, for comparing runs that should be identical
+Uint64 SimCore::checksum() const {
+    const SimState& s = current;
+    const RecruitPlatoon& recruits = s.recruits;
+    Uint64 hash = 14695981039346656037ULL;
+    Sint32 counters[] = {recruits.holder(0), recruits.animationFrame(0), s.diFrame, s.catchCount, s.gearCollected, recruits.isHeld(0), s.gameOver,
+                         s.tick, s.weatherTimer, recruits.heldTicks(0)};
+    float values[] = {recruits.xs()[0], recruits.ys()[0], s.objectives.xs()[0], s.objectives.ys()[0], recruits.getStamina(0)};
+    Uint64 rngState = rng.getState();
+    hashBytes(hash, counters, sizeof(counters));
+    hashBytes(hash, values, sizeof(values));
+    hashBytes(hash, &rngState, sizeof(rngState));
+    hashBytes(hash, s.drillInstructors.xs(), s.drillInstructors.size() * sizeof(float));
+    hashBytes(hash, s.drillInstructors.ys(), s.drillInstructors.size() * sizeof(float));
+    // The rest of a platoon and further objectives come last, so a lone recruit after one objective
+    // hashes the same as before they were entities
+    for (int i = 1; i < recruits.size(); ++i) {
+        Sint32 recruitCounters[] = {recruits.holder(i), recruits.animationFrame(i), recruits.heldTicks(i)};
+        float recruitValues[] = {recruits.xs()[i], recruits.ys()[i], recruits.getStamina(i)};
+        hashBytes(hash, recruitCounters, sizeof(recruitCounters));
+        hashBytes(hash, recruitValues, sizeof(recruitValues));
+    }
+    for (int i = 1; i < s.objectives.size(); ++i) {
+        Sint32 collected = s.objectives.isCollected(i);
+        hashBytes(hash, &collected, sizeof(collected));
+    }
+    return hash;
+}
@@ -0,0 +1,115 @@
+#ifndef SIM_CORE_H
+#define SIM_CORE_H
+
+#include "common.h"
+#include "world_map.h"
+#include "spatial_grid.h"
+#include "entity_grid.h"
+#include "flow_field.h"
+#include "di_swarm.h"
+#include "archetypes.h"
+#include "rng.h"
+#include "profiler.h"
+#include "job_system.h"
+#include <vector>
+
+const int LATCH_DURATION = 120;      // Ticks to stay latched before automatic escape (2 seconds at 60 Hz)
+const int CATCH_COOLDOWN = 120;      // Ticks before a DI that let go can catch again
+const int MAX_CATCHES = 15;          // Catches before the game is lost
+const float CATCH_RADIUS = 20.0f;
+const float PICKUP_RADIUS = 20.0f;
+const float TAUNT_RADIUS = 100.0f;   // DIs this close get the recruit taunted
+const int DI_JOB_GRAIN = 64;         // DIs moved per job when a JobSystem is attached
+const int RECRUIT_JOB_GRAIN = 64;    // Recruits moved per job
+const int PLATOON_COLUMNS = 5;       // Recruits per rank when a platoon falls in at the start
+const int MAX_DRILL_INSTRUCTORS = 100000;  // Largest counts a session may ask for, on the command line or in a replay
+const int MAX_RECRUITS = 10000;
+const int MAX_OBJECTIVES = 10000;
+const int DI_SPAWN_ATTEMPTS = 16;    // Random spawn points tried per DI before giving up on a crowded map
+
+// Player intent for one tick
+struct SimInput {
+    int moveX = 0, moveY = 0;  // -1, 0 or 1 per axis
+    bool sprint = false;
+    bool escape = false;       // Escape attempt (space) since the last tick
+};
+
+enum SimEventType {
+    SIM_EVENT_CAUGHT,           // value: catches so far
+    SIM_EVENT_ESCAPED,
+    SIM_EVENT_ESCAPE_FAILED,
+    SIM_EVENT_AUTO_ESCAPED,
+    SIM_EVENT_OBJECTIVE_COLLECTED,  // value: objectives left (the last one raises SIM_EVENT_GEAR_COLLECTED instead)
+    SIM_EVENT_GEAR_COLLECTED,
+    SIM_EVENT_GAME_OVER,
+    SIM_EVENT_FOOTSTEP              // value: recruits that stepped
+};
+
+struct SimEvent {
+    SimEventType type;
+    int value;
+};
+
+// Everything a tick reads and writes. Plain data, so front ends can read it freely between steps.
+// Entities live in one structure-of-arrays archetype per kind.
+struct SimState {
+    RecruitPlatoon recruits;  // [0] is the one the camera follows and the HUD describes
+    PickupSet objectives;     // Gear; the mission is complete once every piece is collected
+    DrillInstructorSwarm drillInstructors;
+    int diFrame = 0, catchCount = 0;  // Catches of any recruit count towards MAX_CATCHES
+    bool gearCollected = false, gameOver = false;
+    bool storming = false;  // Dust storm this tick (cosmetic, but timed by the simulation)
+    bool diNearby = false;  // A DI is within TAUNT_RADIUS of a free recruit (for the taunt text)
+    int tick = 0, weatherTimer = 0;
+};
+
+// The game rules without SDL video, audio or timing: given a map, a seed and one SimInput per tick,
+// step() always produces the same states and events, whether behind a window or headless. A tick
+// runs systems in a fixed order, each one a loop over the archetypes that have its components:
+// escape, stamina, movement (recruits, later DIs), holding, pursuit, catching, pickup, animation.
+class SimCore {
+private:
+    const WorldMap* world = nullptr;
+    SpatialGrid collisionGrid;          // Static structures, built once in init()
+    EntityGrid diGrid;                  // DI positions, rebuilt every tick after they move
+    EntityGrid pickupGrid;              // Gear still lying on the map
+    std::vector<int> nearbyStructures;  // Scratch buffer for collision queries
+    FlowField pursuitField;             // Paths toward the nearest pursued recruit, shared by every DI
+    std::vector<int> pursued;           // Recruits the DIs chase this tick
+    std::vector<Vector2> pursuedCenters;
+    Rng rng;
+    SimState current;
+    std::vector<SimEvent> tickEvents;
+    Profiler* profiler = nullptr;
+    JobSystem* jobs = nullptr;          // Spreads DI movement over cores; results don't depend on it
+    float recruitSpeed = 1.5f, sprintSpeed = 3.0f, diSpeed = 1.5f;  // Match recruitSpeed and diSpeed, increase sprintSpeed slightly
+    float maxStamina = 100.0f, staminaDrain = 0.1f, staminaRegen = 0.2f;
+
+    // Collision helpers are const and take their query scratch buffer, so DIs can move on several threads
+    Vector2 slideAroundObstacle(Vector2 pos, Vector2 step, Vector2 target, const SDL_Rect& obstacle) const;
+    int moveThroughStructures(Vector2& pos, Vector2 step, std::vector<int>& nearby) const;
+    void stayOnGround(Vector2& pos, std::vector<int>& nearby) const;
+    bool isBlocked(Vector2 pos, std::vector<int>& nearby) const;
+    void moveSystem(const MoverArrays& movers, int begin, int end, int* sandPits, std::vector<int>& nearby) const;
+    void moveAll(const MoverArrays& movers, int grain, int* sandPits);
+    void releaseRecruit(int recruit);
+    void escapeSystem(const SimInput& input);
+    void staminaSystem(const SimInput& input, Vector2 direction);
+    void holdSystem();
+    void pursuitSystem();
+    void catchSystem();
+    void pickupSystem();
+    void animationSystem(Vector2 direction);
+
+public:
+    bool init(const WorldMap* map, int drillInstructorCount, Uint64 seed, int recruitCount = 1, int objectiveCount = 1);
+    void step(const SimInput& input);
+    const SimState& state() const { return current; }
+    const std::vector<SimEvent>& events() const { return tickEvents; }  // Raised by the last step()
+    const SpatialGrid& grid() const { return collisionGrid; }
+    Uint64 checksum() const;
+    void setProfiler(Profiler* owner) { profiler = owner; }  // Times recruit movement and DI AI
+    void setJobSystem(JobSystem* pool) { jobs = pool; }
+};
+
+#endif // SIM_CORE_H
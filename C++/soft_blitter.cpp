@@ -0,0 +1,226 @@
+#include "soft_blitter.h"
+#include <algorithm>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SOFT_BLITTER_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+enum SimdLevel { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 };
+
+const Uint32 OPAQUE = 0xff000000u;
+
+// src over dst per channel, with the division by 255 rounded exactly: t = s*a + d*(255-a) + 128,
+// then (t + (t >> 8)) >> 8. Every step fits in 16 bits, which is what lets the SIMD kernels match.
+inline Uint32 blendPixel(Uint32 dst, Uint32 src) {
+    Uint32 a = src >> 24;
+    if (a == 0) return dst | OPAQUE;
+    if (a == 255) return src;
+    Uint32 out = OPAQUE;
+    for (int shift = 0; shift < 24; shift += 8) {
+        Uint32 t = ((src >> shift) & 0xff) * a + ((dst >> shift) & 0xff) * (255 - a) + 128;
+        out |= ((t + (t >> 8)) >> 8) << shift;
+    }
+    return out;
+}
+
+void fillRowScalar(Uint32* dst, int count, Uint32 color) {
+    for (int i = 0; i < count; ++i) dst[i] = color;
+}
+
+void copyRowScalar(Uint32* dst, const Uint32* src, int count) {
+    std::memcpy(dst, src, count * sizeof(Uint32));
+}
+
+void blendRowScalar(Uint32* dst, const Uint32* src, int count) {
+    for (int i = 0; i < count; ++i) dst[i] = blendPixel(dst[i], src[i]);
+}
+
+#ifdef SOFT_BLITTER_SIMD
+__attribute__((target("sse2")))
+void fillRowSSE2(Uint32* dst, int count, Uint32 color) {
+    const __m128i c = _mm_set1_epi32(static_cast<int>(color));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), c);
+    fillRowScalar(dst + i, count - i, color);
+}
+
+__attribute__((target("sse2")))
+void copyRowSSE2(Uint32* dst, const Uint32* src, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+    }
+    copyRowScalar(dst + i, src + i, count - i);
+}
+
+// Two pixels per 16-bit half: widen, blend as in blendPixel(), narrow
+__attribute__((target("sse2")))
+inline __m128i blendHalfSSE2(__m128i s, __m128i d) {
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i t = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a))),
+                              _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("sse2")))
+void blendRowSSE2(Uint32* dst, const Uint32* src, int count) {
+    const __m128i zero = _mm_setzero_si128(), opaque = _mm_set1_epi32(static_cast<int>(OPAQUE));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i low = blendHalfSSE2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+        __m128i high = blendHalfSSE2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_packus_epi16(low, high), opaque));
+    }
+    blendRowScalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void fillRowAVX2(Uint32* dst, int count, Uint32 color) {
+    const __m256i c = _mm256_set1_epi32(static_cast<int>(color));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), c);
+    fillRowScalar(dst + i, count - i, color);
+}
+
+__attribute__((target("avx2")))
+void copyRowAVX2(Uint32* dst, const Uint32* src, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+    }
+    copyRowScalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx2")))
+inline __m256i blendHalfAVX2(__m256i s, __m256i d) {
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m256i t = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), a))),
+                                 _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+// Unpack and pack both work within 128-bit lanes, so the pixel order survives the round trip
+__attribute__((target("avx2")))
+void blendRowAVX2(Uint32* dst, const Uint32* src, int count) {
+    const __m256i zero = _mm256_setzero_si256(), opaque = _mm256_set1_epi32(static_cast<int>(OPAQUE));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i low = blendHalfAVX2(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero));
+        __m256i high = blendHalfAVX2(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(_mm256_packus_epi16(low, high), opaque));
+    }
+    blendRowScalar(dst + i, src + i, count - i);
+}
+#endif
+
+void fillRow(int level, Uint32* dst, int count, Uint32 color) {
+    switch (level) {
+#ifdef SOFT_BLITTER_SIMD
+    case SIMD_AVX2: fillRowAVX2(dst, count, color); break;
+    case SIMD_SSE2: fillRowSSE2(dst, count, color); break;
+#endif
+    default: fillRowScalar(dst, count, color); break;
+    }
+}
+
+void copyRow(int level, Uint32* dst, const Uint32* src, int count) {
+    switch (level) {
+#ifdef SOFT_BLITTER_SIMD
+    case SIMD_AVX2: copyRowAVX2(dst, src, count); break;
+    case SIMD_SSE2: copyRowSSE2(dst, src, count); break;
+#endif
+    default: copyRowScalar(dst, src, count); break;
+    }
+}
+
+void blendRow(int level, Uint32* dst, const Uint32* src, int count) {
+    switch (level) {
+#ifdef SOFT_BLITTER_SIMD
+    case SIMD_AVX2: blendRowAVX2(dst, src, count); break;
+    case SIMD_SSE2: blendRowSSE2(dst, src, count); break;
+#endif
+    default: blendRowScalar(dst, src, count); break;
+    }
+}
+
+// Shrink srcRect (and move x, y with it) until it lies inside both images; false if nothing is left
+bool clipBlit(const PixelView& dst, int& x, int& y, const PixelView& src, SDL_Rect& rect) {
+    if (rect.x < 0) { x -= rect.x; rect.w += rect.x; rect.x = 0; }
+    if (rect.y < 0) { y -= rect.y; rect.h += rect.y; rect.y = 0; }
+    rect.w = std::min(rect.w, src.width - rect.x);
+    rect.h = std::min(rect.h, src.height - rect.y);
+    if (x < 0) { rect.x -= x; rect.w += x; x = 0; }
+    if (y < 0) { rect.y -= y; rect.h += y; y = 0; }
+    rect.w = std::min(rect.w, dst.width - x);
+    rect.h = std::min(rect.h, dst.height - y);
+    return rect.w > 0 && rect.h > 0;
+}
+
+}  // namespace
+
+SoftBlitter::SoftBlitter() {
+#ifdef SOFT_BLITTER_SIMD
+    level = SDL_HasAVX2() ? SIMD_AVX2 : (SDL_HasSSE2() ? SIMD_SSE2 : SIMD_SCALAR);
+#else
+    level = SIMD_SCALAR;
+#endif
+}
+
+const char* SoftBlitter::kernelName() const {
+    return level == SIMD_AVX2 ? "AVX2" : (level == SIMD_SSE2 ? "SSE2" : "scalar");
+}
+
+void SoftBlitter::fill(const PixelView& dst, SDL_Rect rect, Uint32 color) const {
+    int x0 = std::max(rect.x, 0), y0 = std::max(rect.y, 0);
+    int x1 = std::min(rect.x + rect.w, dst.width), y1 = std::min(rect.y + rect.h, dst.height);
+    if (x0 >= x1) return;
+    for (int y = y0; y < y1; ++y) fillRow(level, dst.pixels + static_cast<size_t>(y) * dst.pitch + x0, x1 - x0, color);
+}
+
+void SoftBlitter::copy(const PixelView& dst, int x, int y, const PixelView& src, SDL_Rect srcRect) const {
+    if (!clipBlit(dst, x, y, src, srcRect)) return;
+    for (int row = 0; row < srcRect.h; ++row) {
+        copyRow(level, dst.pixels + static_cast<size_t>(y + row) * dst.pitch + x,
+                src.pixels + static_cast<size_t>(srcRect.y + row) * src.pitch + srcRect.x, srcRect.w);
+    }
+}
+
+void SoftBlitter::blend(const PixelView& dst, int x, int y, const PixelView& src, SDL_Rect srcRect) const {
+    if (!clipBlit(dst, x, y, src, srcRect)) return;
+    for (int row = 0; row < srcRect.h; ++row) {
+        blendRow(level, dst.pixels + static_cast<size_t>(y + row) * dst.pitch + x,
+                 src.pixels + static_cast<size_t>(srcRect.y + row) * src.pitch + srcRect.x, srcRect.w);
+    }
+}
+
+// Each destination row is gathered from the source into a scratch row, then blended like blend()
+void SoftBlitter::blendScaled(const PixelView& dst, SDL_Rect dstRect, const PixelView& src, SDL_Rect srcRect) const {
+    if (srcRect.w == dstRect.w && srcRect.h == dstRect.h) {
+        blend(dst, dstRect.x, dstRect.y, src, srcRect);
+        return;
+    }
+    if (dstRect.w <= 0 || dstRect.h <= 0 || srcRect.w <= 0 || srcRect.h <= 0) return;
+    int x0 = std::max(dstRect.x, 0), y0 = std::max(dstRect.y, 0);
+    int x1 = std::min(dstRect.x + dstRect.w, dst.width), y1 = std::min(dstRect.y + dstRect.h, dst.height);
+    if (x0 >= x1) return;
+    static thread_local std::vector<Uint32> scratch;  // Chunks are rasterized on several workers at once
+    scratch.resize(x1 - x0);
+    for (int y = y0; y < y1; ++y) {
+        int sy = srcRect.y + static_cast<int>(static_cast<long long>(y - dstRect.y) * srcRect.h / dstRect.h);
+        if (sy < 0 || sy >= src.height) continue;
+        const Uint32* srcRow = src.pixels + static_cast<size_t>(sy) * src.pitch;
+        for (int x = x0; x < x1; ++x) {
+            int sx = srcRect.x + static_cast<int>(static_cast<long long>(x - dstRect.x) * srcRect.w / dstRect.w);
+            scratch[x - x0] = (sx >= 0 && sx < src.width) ? srcRow[sx] : 0;  // Outside the source: transparent
+        }
+        blendRow(level, dst.pixels + static_cast<size_t>(y) * dst.pitch + x0, scratch.data(), x1 - x0);
+    }
+}
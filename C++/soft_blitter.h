@@ -0,0 +1,49 @@
+#ifndef SOFT_BLITTER_H
+#define SOFT_BLITTER_H
+
+#include "common.h"
+#include <vector>
+
+const Uint32 SOFT_PIXEL_FORMAT = SDL_PIXELFORMAT_ARGB8888;
+
+// ARGB8888 pixels owned by someone else; pitch is in pixels
+struct PixelView {
+    Uint32* pixels = nullptr;
+    int width = 0, height = 0, pitch = 0;
+};
+
+// An ARGB8888 image that owns its pixels
+struct PixelImage {
+    std::vector<Uint32> pixels;
+    int width = 0, height = 0;
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        pixels.resize(static_cast<size_t>(w) * h);
+    }
+    PixelView view() { return {pixels.data(), width, height, width}; }
+    PixelView view() const { return {const_cast<Uint32*>(pixels.data()), width, height, width}; }  // Only to read from
+};
+
+inline Uint32 packArgb(SDL_Color color) {
+    return (static_cast<Uint32>(color.a) << 24) | (color.r << 16) | (color.g << 8) | color.b;
+}
+
+// Fixed-format blits for the software world renderer: solid fills, opaque copies and alpha-blended
+// sprites on ARGB8888, with AVX2, SSE2 or scalar row kernels picked once for the running CPU. Every
+// kernel produces the same pixels. Blits are clipped to both images; results are opaque.
+class SoftBlitter {
+private:
+    int level;
+
+public:
+    SoftBlitter();
+    const char* kernelName() const;
+    void fill(const PixelView& dst, SDL_Rect rect, Uint32 color) const;
+    void copy(const PixelView& dst, int x, int y, const PixelView& src, SDL_Rect srcRect) const;
+    void blend(const PixelView& dst, int x, int y, const PixelView& src, SDL_Rect srcRect) const;
+    void blendScaled(const PixelView& dst, SDL_Rect dstRect, const PixelView& src, SDL_Rect srcRect) const;  // Nearest neighbor
+};
+
+#endif // SOFT_BLITTER_H
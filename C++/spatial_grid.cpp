@@ -0,0 +1,90 @@
+#include "spatial_grid.h"
+#include <algorithm>
+
+SpatialGrid::SpatialGrid(int cell) : cellSize(cell) {}
+
+void SpatialGrid::clear() {
+    entries.clear();
+    cellStart.clear();
+    cellEntries.clear();
+    cellMask.clear();
+    columns = 0;
+    rows = 0;
+}
+
+// Queue rects for the next build(). Entries keep insertion order, which is also query order.
+void SpatialGrid::add(RectSpan rects, StructureCategory category) {
+    for (const auto& rect : rects) entries.push_back({rect, category});
+}
+
+bool SpatialGrid::cellRange(const SDL_Rect& area, int* firstCol, int* firstRow, int* lastCol, int* lastRow) const {
+    if (columns == 0 || rows == 0 || area.w <= 0 || area.h <= 0) return false;
+    *firstCol = std::max(0, area.x / cellSize);
+    *firstRow = std::max(0, area.y / cellSize);
+    *lastCol = std::min(columns - 1, (area.x + area.w - 1) / cellSize);
+    *lastRow = std::min(rows - 1, (area.y + area.h - 1) / cellSize);
+    return *firstCol <= *lastCol && *firstRow <= *lastRow;
+}
+
+// Bucket every entry into the cells it overlaps (two passes: count, then fill)
+void SpatialGrid::build(int mapW, int mapH) {
+    columns = std::max(1, (mapW + cellSize - 1) / cellSize);
+    rows = std::max(1, (mapH + cellSize - 1) / cellSize);
+    cellStart.assign(columns * rows + 1, 0);
+    cellMask.assign(columns * rows, 0);
+
+    int firstCol, firstRow, lastCol, lastRow;
+    for (const auto& e : entries) {
+        if (!cellRange(e.rect, &firstCol, &firstRow, &lastCol, &lastRow)) continue;
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int col = firstCol; col <= lastCol; ++col) {
+                cellStart[row * columns + col + 1]++;
+                cellMask[row * columns + col] |= categoryBit(e.category);
+            }
+        }
+    }
+    for (size_t i = 1; i < cellStart.size(); ++i) cellStart[i] += cellStart[i - 1];
+
+    cellEntries.assign(cellStart.back(), 0);
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (int i = 0; i < static_cast<int>(entries.size()); ++i) {
+        if (!cellRange(entries[i].rect, &firstCol, &firstRow, &lastCol, &lastRow)) continue;
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int col = firstCol; col <= lastCol; ++col) {
+                cellEntries[fill[row * columns + col]++] = i;
+            }
+        }
+    }
+}
+
+// Collect the entries of the requested categories in the cells overlapping area. Results are unique
+// and sorted by entry index, so callers see structures in the same order they were added.
+void SpatialGrid::query(const SDL_Rect& area, Uint32 categoryMask, std::vector<int>& out) const {
+    out.clear();
+    int firstCol, firstRow, lastCol, lastRow;
+    if (!cellRange(area, &firstCol, &firstRow, &lastCol, &lastRow)) return;
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) {
+            int cell = row * columns + col;
+            if (!(cellMask[cell] & categoryMask)) continue;
+            for (int i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+                if (categoryBit(entries[cellEntries[i]].category) & categoryMask) out.push_back(cellEntries[i]);
+            }
+        }
+    }
+    if (firstCol != lastCol || firstRow != lastRow) {  // Rects spanning several cells show up more than once
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+}
+
+// Categories present in the cells overlapping area (coarse: cell-level, not rect-level)
+Uint32 SpatialGrid::categoriesIn(const SDL_Rect& area) const {
+    Uint32 mask = 0;
+    int firstCol, firstRow, lastCol, lastRow;
+    if (!cellRange(area, &firstCol, &firstRow, &lastCol, &lastRow)) return 0;
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) mask |= cellMask[row * columns + col];
+    }
+    return mask;
+}
@@ -0,0 +1,36 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include "common.h"
+#include <vector>
+
+struct GridEntry {
+    SDL_Rect rect;
+    StructureCategory category;
+};
+
+// Uniform grid over the static map. Built once; every cell lists the structures overlapping it
+// plus a bitmask of their categories, so movement only looks at what is near the sprite.
+class SpatialGrid {
+private:
+    int cellSize;
+    int columns = 0, rows = 0;
+    std::vector<GridEntry> entries;
+    std::vector<int> cellStart;    // Offsets into cellEntries, one per cell plus a terminator
+    std::vector<int> cellEntries;  // Entry indices, grouped by cell
+    std::vector<Uint32> cellMask;  // Categories present in each cell
+
+    bool cellRange(const SDL_Rect& area, int* firstCol, int* firstRow, int* lastCol, int* lastRow) const;
+
+public:
+    explicit SpatialGrid(int cell = COLLISION_CELL_SIZE);
+    void clear();
+    void add(RectSpan rects, StructureCategory category);
+    void build(int mapW, int mapH);
+    void query(const SDL_Rect& area, Uint32 categoryMask, std::vector<int>& out) const;
+    Uint32 categoriesIn(const SDL_Rect& area) const;
+    const GridEntry& entry(int index) const { return entries[index]; }
+    size_t size() const { return entries.size(); }
+};
+
+#endif // SPATIAL_GRID_H
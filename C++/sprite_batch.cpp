@@ -0,0 +1,88 @@
+#include "sprite_batch.h"
+#include <algorithm>
+
+SpriteBatch::SpriteBatch(SDL_Renderer* rend) : renderer(rend) {}
+
+SDL_Point SpriteBatch::textureSize(SDL_Texture* texture) {
+    auto found = textureSizes.find(texture);
+    if (found != textureSizes.end()) return found->second;
+    SDL_Point size = {1, 1};
+    SDL_QueryTexture(texture, NULL, NULL, &size.x, &size.y);
+    textureSizes[texture] = size;
+    return size;
+}
+
+// Queue a textured quad; a null texture becomes a flat rect in tint
+void SpriteBatch::add(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect& dst, int layer, SDL_Color tint) {
+    SpriteQuad quad = {texture, layer, src ? *src : SDL_Rect{0, 0, 0, 0}, dst, tint};
+    quads.push_back(quad);
+}
+
+void SpriteBatch::addRect(const SDL_Rect& dst, SDL_Color color, int layer) {
+    quads.push_back({nullptr, layer, {0, 0, 0, 0}, dst, color});
+}
+
+// Draw quads [begin, end), which all share one layer and texture, modulated by ambient
+void SpriteBatch::submit(size_t begin, size_t end, SDL_Color ambient) {
+    SDL_Texture* texture = quads[begin].texture;
+    bool lit = ambient.r != 255 || ambient.g != 255 || ambient.b != 255;
+    if (!geometrySupported) {
+        for (size_t i = begin; i < end; ++i) {
+            const SpriteQuad& quad = quads[i];
+            SDL_Color color = lit ? modulate(quad.color, ambient) : quad.color;
+            if (texture) {
+                SDL_SetTextureColorMod(texture, color.r, color.g, color.b);
+                SDL_RenderCopy(renderer, texture, quad.src.w > 0 ? &quad.src : NULL, &quad.dst);
+            } else {
+                SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+                SDL_RenderFillRect(renderer, &quad.dst);
+            }
+            drawCalls++;
+        }
+        if (texture) SDL_SetTextureColorMod(texture, 255, 255, 255);
+        return;
+    }
+
+    vertices.clear();
+    indices.clear();
+    SDL_Point size = texture ? textureSize(texture) : SDL_Point{1, 1};
+    for (size_t i = begin; i < end; ++i) {
+        const SpriteQuad& quad = quads[i];
+        SDL_Color color = lit ? modulate(quad.color, ambient) : quad.color;  // Geometry takes its color mod per vertex
+        SDL_Rect src = quad.src.w > 0 ? quad.src : SDL_Rect{0, 0, size.x, size.y};
+        float x0 = static_cast<float>(quad.dst.x), y0 = static_cast<float>(quad.dst.y);
+        float x1 = x0 + quad.dst.w, y1 = y0 + quad.dst.h;
+        float u0 = static_cast<float>(src.x) / size.x, v0 = static_cast<float>(src.y) / size.y;
+        float u1 = static_cast<float>(src.x + src.w) / size.x, v1 = static_cast<float>(src.y + src.h) / size.y;
+        int base = static_cast<int>(vertices.size());
+        vertices.push_back({{x0, y0}, color, {u0, v0}});
+        vertices.push_back({{x1, y0}, color, {u1, v0}});
+        vertices.push_back({{x1, y1}, color, {u1, v1}});
+        vertices.push_back({{x0, y1}, color, {u0, v1}});
+        indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+    }
+    if (SDL_RenderGeometry(renderer, texture, vertices.data(), static_cast<int>(vertices.size()),
+                           indices.data(), static_cast<int>(indices.size())) < 0) {
+        geometrySupported = false;  // SDL older than 2.0.18, or a renderer without geometry support
+        submit(begin, end, ambient);
+        return;
+    }
+    drawCalls++;
+}
+
+// Sort by layer then texture (stable, so submission order survives within a group) and draw
+void SpriteBatch::flush(SDL_Color ambient) {
+    drawCalls = 0;
+    std::stable_sort(quads.begin(), quads.end(), [](const SpriteQuad& a, const SpriteQuad& b) {
+        if (a.layer != b.layer) return a.layer < b.layer;
+        return std::less<SDL_Texture*>()(a.texture, b.texture);
+    });
+    size_t begin = 0;
+    for (size_t i = 1; i <= quads.size(); ++i) {
+        if (i == quads.size() || quads[i].layer != quads[begin].layer || quads[i].texture != quads[begin].texture) {
+            submit(begin, i, quads[begin].layer < LAYER_HUD ? ambient : WHITE);
+            begin = i;
+        }
+    }
+    quads.clear();
+}
@@ -0,0 +1,53 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include "common.h"
+#include <unordered_map>
+#include <vector>
+
+// Draw order of everything the Renderer submits; quads in the same layer are grouped by texture
+enum SpriteLayer {
+    LAYER_MAP = 0,  // Map chunks, or LAYER_MAP + draw position when structures are drawn one by one
+    LAYER_RECRUIT = 16,
+    LAYER_DRILL_INSTRUCTORS,
+    LAYER_GEAR,
+    LAYER_HUD
+};
+
+struct SpriteQuad {
+    SDL_Texture* texture;  // nullptr for a flat-colored rect
+    int layer;
+    SDL_Rect src;          // Ignored for flat rects; w == 0 means the whole texture
+    SDL_Rect dst;
+    SDL_Color color;       // Tint for textured quads, fill color for flat rects
+};
+
+// Collects quads over a frame and submits them with as few SDL_RenderGeometry calls as possible:
+// one per run of equal (layer, texture) after a stable sort. Falls back to SDL_RenderCopy and
+// SDL_RenderFillRect if the renderer cannot draw geometry. The ambient color given to flush()
+// modulates every layer below LAYER_HUD, folded into the colors already sent, so lighting costs
+// no extra pass.
+class SpriteBatch {
+private:
+    SDL_Renderer* renderer;
+    std::vector<SpriteQuad> quads;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+    std::unordered_map<SDL_Texture*, SDL_Point> textureSizes;
+    bool geometrySupported = true;
+    int drawCalls = 0;
+
+    SDL_Point textureSize(SDL_Texture* texture);
+    void submit(size_t begin, size_t end, SDL_Color ambient);
+
+public:
+    explicit SpriteBatch(SDL_Renderer* rend);
+    void add(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect& dst, int layer, SDL_Color tint = WHITE);
+    void add(const SpriteQuad& quad) { quads.push_back(quad); }
+    void addRect(const SDL_Rect& dst, SDL_Color color, int layer);
+    void flush(SDL_Color ambient = WHITE);
+    void forgetTexture(SDL_Texture* texture) { textureSizes.erase(texture); }
+    int lastDrawCalls() const { return drawCalls; }
+};
+
+#endif // SPRITE_BATCH_H
@@ -0,0 +1,142 @@
+#include "text_renderer.h"
+#include <iostream>
+#include <algorithm>
+
+TextRenderer::TextRenderer(SDL_Renderer* rend, TTF_Font* ttfFont) : renderer(rend), font(ttfFont) {
+    for (auto& glyph : glyphs) glyph = {{0, 0, 0, 0}, 0};
+    if (font && !buildAtlas()) {
+        std::cerr << "Failed to build glyph atlas: " << SDL_GetError() << " " << TTF_GetError() << std::endl;
+    }
+}
+
+TextRenderer::~TextRenderer() {
+    if (atlas) SDL_DestroyTexture(atlas);
+}
+
+// Rasterize every printable ASCII glyph once (white, so vertex colors can tint it) and pack them in rows
+bool TextRenderer::buildAtlas() {
+    lineHeight = TTF_FontHeight(font);
+    SDL_Surface* glyphSurfaces[GLYPH_LAST - GLYPH_FIRST + 1] = {};
+    int penX = 0, penY = 0, rowHeight = 0;
+    for (int c = GLYPH_FIRST; c <= GLYPH_LAST; ++c) {
+        char str[2] = {static_cast<char>(c), '\0'};
+        SDL_Surface* surface = TTF_RenderUTF8_Blended(font, str, WHITE);
+        int minX, maxX, minY, maxY, advance;
+        if (TTF_GlyphMetrics(font, static_cast<Uint16>(c), &minX, &maxX, &minY, &maxY, &advance) < 0) advance = surface ? surface->w : 0;
+        Glyph& glyph = glyphs[c - GLYPH_FIRST];
+        glyph.advance = advance;
+        glyphSurfaces[c - GLYPH_FIRST] = surface;
+        if (!surface) continue;  // Space renders as an empty surface on some SDL_ttf versions
+        if (penX + surface->w > GLYPH_ATLAS_WIDTH) {
+            penX = 0;
+            penY += rowHeight + 1;
+            rowHeight = 0;
+        }
+        glyph.src = {penX, penY, surface->w, surface->h};
+        penX += surface->w + 1;  // 1px gap so linear filtering never bleeds into a neighbour
+        rowHeight = std::max(rowHeight, surface->h);
+    }
+
+    SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, GLYPH_ATLAS_WIDTH, penY + rowHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    bool ok = atlasSurface != nullptr;
+    if (ok) {
+        SDL_FillRect(atlasSurface, NULL, SDL_MapRGBA(atlasSurface->format, 255, 255, 255, 0));
+        for (int c = GLYPH_FIRST; c <= GLYPH_LAST; ++c) {
+            SDL_Surface* surface = glyphSurfaces[c - GLYPH_FIRST];
+            if (!surface) continue;
+            SDL_Rect dst = glyphs[c - GLYPH_FIRST].src;
+            SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);  // Copy alpha as-is
+            SDL_BlitSurface(surface, NULL, atlasSurface, &dst);
+        }
+        atlas = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+        atlasWidth = atlasSurface->w;
+        atlasHeight = atlasSurface->h;
+        if (atlas) SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+        ok = atlas != nullptr;
+        SDL_FreeSurface(atlasSurface);
+    }
+    for (auto* surface : glyphSurfaces) {
+        if (surface) SDL_FreeSurface(surface);
+    }
+    return ok;
+}
+
+// Look up (or build) the quads for text in color. Only strings not seen before are laid out.
+const TextLayout& TextRenderer::layout(const std::string& text, SDL_Color color) {
+    std::string key = text;
+    key.push_back('\0');
+    key.append({static_cast<char>(color.r), static_cast<char>(color.g), static_cast<char>(color.b), static_cast<char>(color.a)});
+    auto found = layoutCache.find(key);
+    if (found != layoutCache.end()) return found->second;
+
+    if (layoutCache.size() >= TEXT_CACHE_LIMIT) layoutCache.clear();  // HUD strings are few, a full flush is enough
+
+    const float atlasW = static_cast<float>(atlasWidth), atlasH = static_cast<float>(atlasHeight);
+    TextLayout& result = layoutCache[key];
+    result.vertices.reserve(text.size() * 4);
+    int penX = 0;
+    for (char ch : text) {
+        int c = static_cast<unsigned char>(ch);
+        if (c < GLYPH_FIRST || c > GLYPH_LAST) c = '?';
+        const Glyph& glyph = glyphs[c - GLYPH_FIRST];
+        if (glyph.src.w > 0 && glyph.src.h > 0) {
+            float x0 = static_cast<float>(penX), y0 = 0.0f;
+            float x1 = x0 + glyph.src.w, y1 = y0 + glyph.src.h;
+            float u0 = static_cast<float>(glyph.src.x) / atlasW, v0 = static_cast<float>(glyph.src.y) / atlasH;
+            float u1 = static_cast<float>(glyph.src.x + glyph.src.w) / atlasW, v1 = static_cast<float>(glyph.src.y + glyph.src.h) / atlasH;
+            result.vertices.push_back({{x0, y0}, color, {u0, v0}});
+            result.vertices.push_back({{x1, y0}, color, {u1, v0}});
+            result.vertices.push_back({{x1, y1}, color, {u1, v1}});
+            result.vertices.push_back({{x0, y1}, color, {u0, v1}});
+        }
+        penX += glyph.advance;
+    }
+    result.width = penX;
+    result.height = lineHeight;
+    return result;
+}
+
+void TextRenderer::measureText(const std::string& text, int* w, int* h) {
+    if (!isReady()) {
+        if (w) *w = 0;
+        if (h) *h = 0;
+        return;
+    }
+    const TextLayout& laidOut = layout(text, WHITE);
+    if (w) *w = laidOut.width;
+    if (h) *h = laidOut.height;
+}
+
+// Queue text with its top-left corner at (x, y); nothing is drawn until flush()
+void TextRenderer::drawText(const std::string& text, SDL_Color color, int x, int y) {
+    if (!isReady()) return;
+    const TextLayout& laidOut = layout(text, color);
+    batchRects.push_back({x, y, laidOut.width, laidOut.height});
+    for (size_t i = 0; i < laidOut.vertices.size(); i += 4) {
+        int base = static_cast<int>(batchVertices.size());
+        for (size_t v = i; v < i + 4; ++v) {
+            SDL_Vertex vertex = laidOut.vertices[v];
+            vertex.position.x += x;
+            vertex.position.y += y;
+            batchVertices.push_back(vertex);
+        }
+        batchIndices.insert(batchIndices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+    }
+}
+
+// HUD style: shadow offset 2px down-right, drawn underneath the text
+void TextRenderer::drawTextWithShadow(const std::string& text, SDL_Color color, SDL_Color shadow, int x, int y) {
+    drawText(text, shadow, x + 2, y + 2);
+    drawText(text, color, x, y);
+}
+
+// Submit every queued string in one draw call, in the order they were queued
+void TextRenderer::flush() {
+    if (!batchIndices.empty()) {
+        SDL_RenderGeometry(renderer, atlas, batchVertices.data(), static_cast<int>(batchVertices.size()),
+                           batchIndices.data(), static_cast<int>(batchIndices.size()));
+    }
+    batchVertices.clear();
+    batchIndices.clear();
+    batchRects.clear();
+}
@@ -0,0 +1,55 @@
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include "common.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+const int GLYPH_FIRST = 32;   // First printable ASCII character kept in the atlas (space)
+const int GLYPH_LAST = 126;   // Last printable ASCII character kept in the atlas (~)
+const int GLYPH_ATLAS_WIDTH = 512;
+const size_t TEXT_CACHE_LIMIT = 64;  // Laid-out strings kept before the cache is flushed
+
+struct Glyph {
+    SDL_Rect src;  // Location of the glyph in the atlas texture
+    int advance;   // Horizontal pen advance after this glyph
+};
+
+// Laid-out string: atlas quads in local coordinates, with the color baked into the vertices
+struct TextLayout {
+    std::vector<SDL_Vertex> vertices;
+    int width = 0, height = 0;
+};
+
+// Draws HUD text from a glyph atlas rasterized once at startup. Strings are laid out once per
+// (text, color) and queued into a single batch that is submitted with SDL_RenderGeometry on flush().
+// Only flush() touches the renderer, so text can be queued on another thread while the scene draws.
+class TextRenderer {
+private:
+    SDL_Renderer* renderer;
+    TTF_Font* font;
+    SDL_Texture* atlas = nullptr;
+    int atlasWidth = 0, atlasHeight = 0;  // Kept so layout() makes no SDL calls and can run on a worker
+    Glyph glyphs[GLYPH_LAST - GLYPH_FIRST + 1];
+    int lineHeight = 0;
+    std::unordered_map<std::string, TextLayout> layoutCache;
+    std::vector<SDL_Vertex> batchVertices;
+    std::vector<int> batchIndices;
+    std::vector<SDL_Rect> batchRects;  // Screen area of every queued string
+
+    bool buildAtlas();
+    const TextLayout& layout(const std::string& text, SDL_Color color);
+
+public:
+    TextRenderer(SDL_Renderer* rend, TTF_Font* ttfFont);
+    ~TextRenderer();
+    bool isReady() const { return atlas != nullptr; }
+    void measureText(const std::string& text, int* w, int* h);
+    void drawText(const std::string& text, SDL_Color color, int x, int y);
+    void drawTextWithShadow(const std::string& text, SDL_Color color, SDL_Color shadow, int x, int y);
+    void flush();
+    const std::vector<SDL_Rect>& queuedRects() const { return batchRects; }  // Until the next flush()
+};
+
+#endif // TEXT_RENDERER_H
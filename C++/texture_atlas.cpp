@@ -0,0 +1,277 @@
+#include "texture_atlas.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+
+// Run decode jobs on the loader's workers when there is one, otherwise here in order
+static bool runDecodes(const std::vector<LoadJob>& jobs, AssetLoader* loader) {
+    if (loader) return loader->runBatch(jobs);
+    bool ok = true;
+    for (const auto& job : jobs) ok = job() && ok;
+    return ok;
+}
+
+TextureAtlas::~TextureAtlas() {
+    freeSources();
+    for (auto& page : pages) {
+        if (page.texture) SDL_DestroyTexture(page.texture);
+        if (page.surface) SDL_FreeSurface(page.surface);
+    }
+}
+
+// Queue an image file; it is only decoded if the disk cache turns out to be stale
+void TextureAtlas::addImage(const std::string& name, const std::string& path) {
+    sources.push_back({name, path, nullptr});
+}
+
+// Queue an image that is already decoded. The atlas takes ownership of surface.
+// Atlases with such images are never cached, since there is no file to check for changes.
+void TextureAtlas::addSurface(const std::string& name, SDL_Surface* surface) {
+    sources.push_back({name, "", surface});
+}
+
+void TextureAtlas::freeSources() {
+    for (auto& source : sources) {
+        if (source.surface) SDL_FreeSurface(source.surface);
+    }
+    sources.clear();
+}
+
+// One line per source with its file's modification time and size; empty if the atlas can't be cached
+std::string TextureAtlas::sourceStamp() const {
+    std::ostringstream stamp;
+    for (const auto& source : sources) {
+        struct stat info;
+        if (source.path.empty() || stat(source.path.c_str(), &info) != 0) return "";
+        stamp << "source " << source.name << " " << source.path << " " << static_cast<long long>(info.st_mtime) << " "
+              << static_cast<long long>(info.st_size) << "\n";
+    }
+    return stamp.str();
+}
+
+// Lowest y at which a w x h box fits with its left edge on skyline[index], or -1 if it doesn't fit
+static int skylineFit(const std::vector<SkylineNode>& skyline, size_t index, int w, int h, int pageW, int pageH) {
+    if (skyline[index].x + w > pageW) return -1;
+    int y = 0, widthLeft = w;
+    for (size_t i = index; widthLeft > 0 && i < skyline.size(); ++i) {
+        y = std::max(y, skyline[i].y);
+        if (y + h > pageH) return -1;
+        widthLeft -= skyline[i].width;
+    }
+    return y;
+}
+
+// Raise the skyline over a box placed at (x, y), trimming the segments it now covers
+static void skylineAdd(std::vector<SkylineNode>& skyline, size_t index, int x, int y, int w, int h) {
+    skyline.insert(skyline.begin() + index, {x, y + h, w});
+    for (size_t i = index + 1; i < skyline.size();) {
+        int coveredTo = skyline[i - 1].x + skyline[i - 1].width;
+        if (skyline[i].x >= coveredTo) break;
+        int shrink = coveredTo - skyline[i].x;
+        skyline[i].x += shrink;
+        skyline[i].width -= shrink;
+        if (skyline[i].width > 0) break;
+        skyline.erase(skyline.begin() + i);
+    }
+    for (size_t i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        } else {
+            ++i;
+        }
+    }
+}
+
+// Find room for a w x h box (padding included) on an existing page, or open a new page.
+// Among all skyline positions the lowest wins, ties go to the leftmost.
+bool TextureAtlas::place(const std::string& name, int w, int h, AtlasRegion* region) {
+    for (size_t p = 0; p < pages.size(); ++p) {
+        AtlasPage& page = pages[p];
+        int bestY = -1;
+        size_t bestIndex = 0;
+        for (size_t i = 0; i < page.skyline.size(); ++i) {
+            int y = skylineFit(page.skyline, i, w, h, page.width, page.height);
+            if (y >= 0 && (bestY < 0 || y < bestY)) {
+                bestY = y;
+                bestIndex = i;
+            }
+        }
+        if (bestY < 0) continue;
+        int x = page.skyline[bestIndex].x;
+        skylineAdd(page.skyline, bestIndex, x, bestY, w, h);
+        region->page = static_cast<int>(p);
+        region->rect = {x, bestY, w - ATLAS_PADDING, h - ATLAS_PADDING};
+        return true;
+    }
+
+    AtlasPage page;
+    page.width = std::max(ATLAS_PAGE_SIZE, w);  // Oversized images get a page of their own
+    page.height = std::max(ATLAS_PAGE_SIZE, h);
+    page.skyline.push_back({0, 0, page.width});
+    pages.push_back(page);
+    if (skylineFit(pages.back().skyline, 0, w, h, page.width, page.height) < 0) {
+        std::cerr << "Atlas image does not fit a page: " << name << std::endl;
+        return false;
+    }
+    return place(name, w, h, region);
+}
+
+// Pack every source, tallest first, then copy them into freshly allocated page surfaces
+bool TextureAtlas::pack() {
+    std::vector<size_t> order(sources.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        if (sources[a].surface->h != sources[b].surface->h) return sources[a].surface->h > sources[b].surface->h;
+        return sources[a].surface->w > sources[b].surface->w;
+    });
+
+    for (size_t i : order) {
+        AtlasRegion region;
+        const Source& source = sources[i];
+        if (!place(source.name, source.surface->w + ATLAS_PADDING, source.surface->h + ATLAS_PADDING, &region)) return false;
+        regions[source.name] = region;
+    }
+
+    for (auto& page : pages) {
+        int usedHeight = 0;
+        for (const auto& node : page.skyline) usedHeight = std::max(usedHeight, node.y);
+        page.height = std::max(1, usedHeight);  // Trim the unused bottom of the page
+        page.surface = SDL_CreateRGBSurfaceWithFormat(0, page.width, page.height, 32, SDL_PIXELFORMAT_RGBA32);
+        if (!page.surface) {
+            std::cerr << "Failed to allocate atlas page: " << SDL_GetError() << std::endl;
+            return false;
+        }
+        SDL_FillRect(page.surface, NULL, SDL_MapRGBA(page.surface->format, 0, 0, 0, 0));
+    }
+    for (const auto& source : sources) {
+        const AtlasRegion& region = regions[source.name];
+        SDL_Rect dst = region.rect;
+        SDL_SetSurfaceBlendMode(source.surface, SDL_BLENDMODE_NONE);  // Copy alpha as-is
+        SDL_BlitSurface(source.surface, NULL, pages[region.page].surface, &dst);
+    }
+    return true;
+}
+
+// Reuse the cached pages if they were packed from exactly these source files
+bool TextureAtlas::loadCache(const std::string& cachePath, const std::string& stamp, AssetLoader* loader) {
+    std::ifstream index(cachePath + ".atlas");
+    if (!index) return false;
+    std::string line, cachedStamp;
+    int version = 0, pageCount = 0;
+    if (!std::getline(index, line) || std::sscanf(line.c_str(), "PIATLAS %d", &version) != 1 || version != ATLAS_CACHE_VERSION) return false;
+    while (std::getline(index, line) && line.compare(0, 7, "source ") == 0) cachedStamp += line + "\n";
+    if (cachedStamp != stamp || std::sscanf(line.c_str(), "pages %d", &pageCount) != 1 || pageCount <= 0) return false;
+
+    std::vector<AtlasPage> cachedPages(pageCount);
+    std::unordered_map<std::string, AtlasRegion> cachedRegions;
+    std::vector<LoadJob> decodes;
+    for (int p = 0; p < pageCount; ++p) {
+        decodes.push_back([&cachedPages, p, cachePath] {
+            std::string pagePath = cachePath + "_" + std::to_string(p) + ".png";
+            SDL_Surface* loaded = IMG_Load(pagePath.c_str());
+            if (loaded) {
+                cachedPages[p].surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+                SDL_FreeSurface(loaded);
+            }
+            return true;  // A missing page only means packing again, which is not a load failure
+        });
+    }
+    runDecodes(decodes, loader);
+    bool ok = true;
+    for (auto& page : cachedPages) {
+        ok = ok && page.surface != nullptr;
+        if (ok) {
+            page.width = page.surface->w;
+            page.height = page.surface->h;
+        }
+    }
+    while (ok && std::getline(index, line)) {
+        std::istringstream fields(line);
+        std::string tag, name;
+        AtlasRegion region;
+        fields >> tag >> name >> region.page >> region.rect.x >> region.rect.y >> region.rect.w >> region.rect.h;
+        ok = fields && tag == "region" && region.page >= 0 && region.page < pageCount;
+        if (ok) cachedRegions[name] = region;
+    }
+    for (const auto& source : sources) ok = ok && cachedRegions.count(source.name) > 0;
+    if (!ok) {
+        for (auto& page : cachedPages) {
+            if (page.surface) SDL_FreeSurface(page.surface);
+        }
+        return false;
+    }
+    pages.swap(cachedPages);
+    regions.swap(cachedRegions);
+    return true;
+}
+
+bool TextureAtlas::saveCache(const std::string& cachePath, const std::string& stamp) const {
+    for (size_t p = 0; p < pages.size(); ++p) {
+        std::string pagePath = cachePath + "_" + std::to_string(p) + ".png";
+        if (IMG_SavePNG(pages[p].surface, pagePath.c_str()) < 0) return false;
+    }
+    std::ofstream index(cachePath + ".atlas");
+    index << "PIATLAS " << ATLAS_CACHE_VERSION << "\n" << stamp << "pages " << pages.size() << "\n";
+    for (const auto& entry : regions) {
+        const SDL_Rect& rect = entry.second.rect;
+        index << "region " << entry.first << " " << entry.second.page << " " << rect.x << " " << rect.y << " " << rect.w << " " << rect.h << "\n";
+    }
+    return static_cast<bool>(index);
+}
+
+// Produce the packed pages: from the cache when it is fresh, otherwise by decoding and packing every
+// source and writing a new cache. Pass an empty cachePath to always pack. With a loader the image files
+// are decoded in parallel on its workers; build() itself only touches surfaces, so it may run on one too.
+bool TextureAtlas::build(const std::string& cachePath, AssetLoader* loader) {
+    std::string stamp = cachePath.empty() ? "" : sourceStamp();
+    if (!stamp.empty() && loadCache(cachePath, stamp, loader)) {
+        freeSources();
+        return true;
+    }
+
+    std::vector<LoadJob> decodes;
+    for (auto& source : sources) {
+        if (source.surface) continue;
+        Source* pending = &source;
+        decodes.push_back([pending] {
+            pending->surface = IMG_Load(pending->path.c_str());
+            if (!pending->surface) std::cerr << "Atlas image failed: " << pending->path << " " << IMG_GetError() << std::endl;
+            return pending->surface != nullptr;
+        });
+    }
+    bool ok = runDecodes(decodes, loader);
+    ok = ok && pack();
+    freeSources();
+    if (ok && !stamp.empty() && !saveCache(cachePath, stamp)) {
+        std::cerr << "Could not write atlas cache " << cachePath << ", it will be packed again next launch" << std::endl;
+    }
+    return ok;
+}
+
+// Create one texture per page. The page surfaces stay around for CPU-side use.
+bool TextureAtlas::upload(SDL_Renderer* renderer) {
+    for (auto& page : pages) {
+        if (page.texture) SDL_DestroyTexture(page.texture);
+        page.texture = SDL_CreateTextureFromSurface(renderer, page.surface);
+        if (!page.texture) {
+            std::cerr << "Failed to create atlas texture: " << SDL_GetError() << std::endl;
+            return false;
+        }
+        SDL_SetTextureBlendMode(page.texture, SDL_BLENDMODE_BLEND);
+    }
+    return true;
+}
+
+AtlasSprite TextureAtlas::sprite(const std::string& name) const {
+    AtlasSprite result;
+    auto found = regions.find(name);
+    if (found == regions.end()) return result;
+    result.texture = pages[found->second.page].texture;
+    result.src = found->second.rect;
+    result.page = found->second.page;
+    return result;
+}
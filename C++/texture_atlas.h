@@ -0,0 +1,74 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include "common.h"
+#include "asset_loader.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+const int ATLAS_PAGE_SIZE = 2048;  // Page width, and the height a page may grow to
+const int ATLAS_PADDING = 1;       // Transparent gap between packed images
+const int ATLAS_CACHE_VERSION = 1;
+
+// A named piece of an atlas page, ready to hand to SDL_RenderCopy or the SpriteBatch
+struct AtlasSprite {
+    SDL_Texture* texture = nullptr;  // nullptr until upload(), or if the name is unknown
+    SDL_Rect src = {0, 0, 0, 0};
+    int page = -1;                   // Index for pageSurface()
+};
+
+struct AtlasRegion {
+    int page;
+    SDL_Rect rect;
+};
+
+// One horizontal segment of a page's skyline: everything below y is taken
+struct SkylineNode {
+    int x, y, width;
+};
+
+struct AtlasPage {
+    int width = 0, height = 0;
+    std::vector<SkylineNode> skyline;
+    SDL_Surface* surface = nullptr;  // Kept after upload for CPU-side consumers
+    SDL_Texture* texture = nullptr;
+};
+
+// Packs many small images into a few large pages at load time (skyline bottom-left packing), so
+// sprites and terrain that share a page can be drawn without texture switches. The packed pages and
+// their region table are cached on disk and reused while every source file is unchanged.
+class TextureAtlas {
+private:
+    struct Source {
+        std::string name;
+        std::string path;       // Empty for surfaces handed in already decoded
+        SDL_Surface* surface;   // Owned until packed
+    };
+    std::vector<Source> sources;
+    std::vector<AtlasPage> pages;
+    std::unordered_map<std::string, AtlasRegion> regions;
+
+    std::string sourceStamp() const;
+    bool place(const std::string& name, int w, int h, AtlasRegion* region);
+    bool pack();
+    bool loadCache(const std::string& cachePath, const std::string& stamp, AssetLoader* loader);
+    bool saveCache(const std::string& cachePath, const std::string& stamp) const;
+    void freeSources();
+
+public:
+    TextureAtlas() = default;
+    ~TextureAtlas();
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    void addImage(const std::string& name, const std::string& path);
+    void addSurface(const std::string& name, SDL_Surface* surface);
+    bool build(const std::string& cachePath, AssetLoader* loader = nullptr);
+    bool upload(SDL_Renderer* renderer);
+    AtlasSprite sprite(const std::string& name) const;
+    int pageCount() const { return static_cast<int>(pages.size()); }
+    SDL_Surface* pageSurface(int page) const { return pages[page].surface; }
+};
+
+#endif // TEXTURE_ATLAS_H
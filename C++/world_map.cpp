@@ -0,0 +1,105 @@
+#include "world_map.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(MAP_FILE_CATEGORY_COUNT == CATEGORY_COUNT, "map_format.h and common.h disagree on the category count");
+static_assert(sizeof(MapFileRect) == sizeof(SDL_Rect), "compiled map rects must be usable as SDL_Rect");
+
+WorldMap::~WorldMap() {
+    unload();
+}
+
+void WorldMap::unload() {
+    if (mapping) munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+}
+
+bool WorldMap::load(const std::string& path) {
+    unload();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Map failed: cannot open " << path << ": " << std::strerror(errno)
+                  << " (compiled maps are built by 'make', see map_compiler.cpp)" << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0 || info.st_size < static_cast<off_t>(sizeof(MapFileHeader))) {
+        std::cerr << "Map failed: " << path << " is too small to be a compiled map" << std::endl;
+        close(fd);
+        return false;
+    }
+    mappingSize = static_cast<size_t>(info.st_size);
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping keeps the file contents alive
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        std::cerr << "Map failed: cannot map " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    header = static_cast<const MapFileHeader*>(mapping);
+
+    std::string error;
+    if (!validate(error)) {
+        std::cerr << "Map failed: " << path << ": " << error << std::endl;
+        unload();
+        return false;
+    }
+    return true;
+}
+
+// Bounds-check everything the accessors hand out, once, so they can index the mapping directly
+bool WorldMap::validate(std::string& error) const {
+    if (std::memcmp(header->magic, MAP_FILE_MAGIC, sizeof(MAP_FILE_MAGIC)) != 0) {
+        error = "not a compiled map (bad magic)";
+        return false;
+    }
+    if (header->version != MAP_FILE_VERSION) {
+        error = "unsupported map version " + std::to_string(header->version);
+        return false;
+    }
+    if (header->width <= 0 || header->height <= 0) {
+        error = "invalid map size";
+        return false;
+    }
+    if (header->stringTableOffset > mappingSize || header->stringTableSize > mappingSize - header->stringTableOffset) {
+        error = "string table out of bounds";
+        return false;
+    }
+    const char* strings = static_cast<const char*>(mapping) + header->stringTableOffset;
+    for (uint32_t i = 0; i < MAP_FILE_CATEGORY_COUNT; ++i) {
+        const MapFileCategory& category = header->categories[i];
+        if (category.rectOffset % alignof(SDL_Rect) != 0 || category.rectOffset > mappingSize ||
+            category.rectCount > (mappingSize - category.rectOffset) / sizeof(MapFileRect)) {
+            error = std::string("rect table out of bounds for ") + MAP_CATEGORY_NAMES[i];
+            return false;
+        }
+        if (category.textureName != MAP_FILE_NO_STRING &&
+            (category.textureName >= header->stringTableSize ||
+             !std::memchr(strings + category.textureName, '\0', header->stringTableSize - category.textureName))) {
+            error = std::string("bad texture name for ") + MAP_CATEGORY_NAMES[i];
+            return false;
+        }
+    }
+    return true;
+}
+
+RectSpan WorldMap::rects(StructureCategory category) const {
+    RectSpan span;
+    if (!header) return span;
+    const MapFileCategory& table = header->categories[category];
+    span.data = reinterpret_cast<const SDL_Rect*>(static_cast<const char*>(mapping) + table.rectOffset);
+    span.count = table.rectCount;
+    return span;
+}
+
+const char* WorldMap::textureName(StructureCategory category) const {
+    if (!header || header->categories[category].textureName == MAP_FILE_NO_STRING) return nullptr;
+    return static_cast<const char*>(mapping) + header->stringTableOffset + header->categories[category].textureName;
+}
@@ -0,0 +1,33 @@
+#ifndef WORLD_MAP_H
+#define WORLD_MAP_H
+
+#include "common.h"
+#include "map_format.h"
+#include <string>
+
+// Immutable world store backed by a memory-mapped compiled map (see map_format.h and map_compiler.cpp).
+// Rect tables are used in place, nothing is parsed or copied; the game and the Renderer share one instance.
+class WorldMap {
+private:
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    const MapFileHeader* header = nullptr;
+
+    bool validate(std::string& error) const;
+    void unload();
+
+public:
+    WorldMap() = default;
+    ~WorldMap();
+    WorldMap(const WorldMap&) = delete;
+    WorldMap& operator=(const WorldMap&) = delete;
+
+    bool load(const std::string& path);
+    bool isLoaded() const { return header != nullptr; }
+    int width() const { return header ? header->width : 0; }
+    int height() const { return header ? header->height : 0; }
+    RectSpan rects(StructureCategory category) const;
+    const char* textureName(StructureCategory category) const;  // nullptr if the map names no texture
+};
+
+#endif // WORLD_MAP_H